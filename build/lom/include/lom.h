@@ -0,0 +1,28 @@
+#pragma once
+
+#include "lom/_internal.h"
+
+#include "lom/code_pos.h"
+#include "lom/err.h"
+#include "lom/go_slice.h"
+#include "lom/iter.h"
+#include "lom/limit.h"
+#include "lom/lru_cache.h"
+#include "lom/lz.h"
+#include "lom/mem.h"
+#include "lom/rand.h"
+#include "lom/str.h"
+#include "lom/time.h"
+#include "lom/token_bucket.h"
+#include "lom/util.h"
+#include "lom/var_int.h"
+
+#include "lom/immut/avl_ds.h"
+#include "lom/immut/avl_util.h"
+#include "lom/immut/avl.h"
+
+#include "lom/io/io.h"
+
+#include "lom/math/prime.h"
+
+#include "lom/fiber/fiber.h"
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../io/io.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+struct AsyncBufWriterOptions
+{
+    /*
+    积压（已写入但未被下层写函数写出）的数据达到high_watermark_时，WriteAll在写入后阻塞，
+    直到积压降到low_watermark_以下，以此对生产者反压，low_watermark_会被调整到不超过high_watermark_
+    */
+    ssize_t high_watermark_ = 4 * 1024 * 1024;
+    ssize_t low_watermark_ = 1 * 1024 * 1024;
+
+    /*
+    后台fiber被唤醒后，在积压不足low_watermark_时最多再等待这么久以积攒更多数据再写出（组提交），
+    <=0表示不等待，此时后台写出期间到来的数据依然会在下一次一起写出
+    有Flush等待时不做这个等待
+    */
+    int64_t flush_delay_ms_ = 0;
+
+    //下层写函数在Offload的线程池中执行，用于会阻塞线程的下层（如原始fd的普通文件），fiber::File不需要
+    bool offload_ = false;
+};
+
+/*
+后台写出的BufWriter，写入的数据进入活动缓冲后立即返回，由一个专门的fiber在后台写出：
+后台fiber每次将活动缓冲整个换出再写出，期间生产者继续写入新的活动缓冲（双缓冲），
+因此后台写出期间的多次小写入会在下一轮合并成一次写操作（指定do_writev时是一次批量写）
+各方法语义：
+    WriteAll：数据写入活动缓冲，在积压达到高水位时等待，单次WriteAll的数据不会和其他fiber的写入交错
+    Flush：等待调用前写入的数据全部被下层写函数写出
+    下层写函数出错后，错误码被记录下来，之后的WriteAll和Flush都返回这个错误码，未写出的数据被丢弃
+对象销毁时，后台fiber会写完剩余的数据后退出，需要确认写出结果的话应在销毁前调用Flush
+只能在创建它的线程的fiber中使用，offload_为true时下层写函数在其他线程执行，不能调用fiber接口或依赖thread_local数据
+*/
+io::BufWriter::Ptr NewAsyncBufWriter(
+    io::BufWriter::DoWriteFunc do_write, const AsyncBufWriterOptions &opts = AsyncBufWriterOptions(),
+    io::BufWriter::DoWriteVFunc do_writev = nullptr);
+
+}
+
+}
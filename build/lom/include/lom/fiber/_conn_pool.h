@@ -0,0 +1,64 @@
+#pragma once
+
+#include "_conn.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+struct ConnPoolOptions
+{
+    //每个key最多缓存的空闲连接数，<=0表示不缓存
+    ssize_t idle_count_max_per_key_ = 16;
+
+    //每个key的最大连接数（包括借出的和空闲的），<=0表示不限制，达到上限时Get会等待其他连接归还
+    ssize_t conn_count_max_per_key_ = 0;
+
+    //空闲连接的超时时间，超时的空闲连接会被后台定期关闭，<=0表示不做超时清理
+    int64_t idle_timeout_ms_ = 60 * 1000;
+};
+
+/*
+按key管理的出向连接池，key的含义由使用者定义（一般就是目标地址），新连接通过创建时传入的DialFunc建立
+和fiber环境中的其他对象一样，连接池只能在创建它的线程中使用
+*/
+class ConnPool
+{
+public:
+
+    typedef std::shared_ptr<ConnPool> Ptr;
+
+    virtual ~ConnPool()
+    {
+    }
+
+    //建立新连接的函数类型，参数和返回值的含义同ConnectTCP等接口
+    typedef std::function<Conn (const Str &key, int64_t timeout_ms, int *err_code)> DialFunc;
+
+    /*
+    获取一个连接，优先复用最近归还的空闲连接，复用前会做无阻塞的健康检查，
+    对端已关闭或有未预期的可读数据的连接会被直接关闭，没有可用的空闲连接时调用DialFunc新建
+    timeout_ms作用于等待连接数上限和新建连接的整个过程
+    返回连接对象，如果出错，连接对象Valid()为false，若err_code不为nullptr，则将错误代码存入
+    */
+    virtual Conn Get(const Str &key, int64_t timeout_ms = -1, int *err_code = nullptr) = 0;
+
+    /*
+    归还通过Get获取的连接，key必须和Get时一致
+    reusable为false表示连接不可再复用（如读写出错、协议状态不确定等），会被直接关闭
+    成功返回0，连接不是通过这个key的Get借出的（或已经归还过）时返回err_code::kInvalid，连接池不做任何处理
+    */
+    virtual int Put(const Str &key, Conn conn, bool reusable = true) = 0;
+
+    //返回指定key当前的空闲连接数和总连接数（包括借出的）
+    virtual ssize_t IdleCount(const Str &key) const = 0;
+    virtual ssize_t ConnCount(const Str &key) const = 0;
+
+    static Ptr New(DialFunc dial, const ConnPoolOptions &opts = ConnPoolOptions());
+};
+
+}
+
+}
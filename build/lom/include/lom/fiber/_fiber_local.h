@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../util.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+//fiber局部存储的key数量上限，key是进程级别的，所有线程共用
+static const ssize_t kFiberLocalKeyCountMax = 64;
+
+/*
+分配一个fiber局部存储的key，返回值范围[0, kFiberLocalKeyCountMax)，key用完则返回-1
+每个fiber对每个key都有一个独立的void *槽位，初始为nullptr，通过key直接下标访问
+destructor不为nullptr时，fiber结束时对其非nullptr的槽位值调用，调用时依然处于此fiber中
+key一般在全局初始化时分配，不可释放
+*/
+ssize_t NewFiberLocalKey(void (*destructor)(void *) = nullptr);
+
+//判断当前是否在fiber中执行
+bool InFiber();
+
+//获取当前fiber中key对应的槽位值，不在fiber中（如在调度器中执行的回调）时返回nullptr
+void *GetFiberLocal(ssize_t key);
+
+//设置当前fiber中key对应的槽位值，不在fiber中时返回false，覆盖旧值时不会对旧值调用destructor
+bool SetFiberLocal(ssize_t key, void *v);
+
+/*
+类型化的fiber局部变量，一般定义为全局或静态变量，例如：
+    static FiberLocal<RequestCtx> req_ctx;
+    req_ctx.Get()->trace_id_ = ...;
+每个fiber第一次Get时默认构造一个T对象，fiber结束时析构
+*/
+template <typename T>
+class FiberLocal
+{
+    ssize_t key_;
+
+    FiberLocal(const FiberLocal &) = delete;
+    FiberLocal &operator=(const FiberLocal &) = delete;
+
+public:
+
+    FiberLocal()
+    {
+        key_ = NewFiberLocalKey(
+            [] (void *p) {
+                delete static_cast<T *>(p);
+            });
+        if (key_ < 0)
+        {
+            Die("lom::fiber::FiberLocal: fiber local keys are exhausted");
+        }
+    }
+
+    //返回当前fiber的T对象，不在fiber中时返回nullptr
+    T *Get() const
+    {
+        T *p = static_cast<T *>(GetFiberLocal(key_));
+        if (p == nullptr && InFiber())
+        {
+            p = new T();
+            SetFiberLocal(key_, p);
+        }
+        return p;
+    }
+};
+
+}
+
+}
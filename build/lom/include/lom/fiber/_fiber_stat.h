@@ -0,0 +1,39 @@
+#pragma once
+
+#include <signal.h>
+
+#include "../code_pos.h"
+#include "../go_slice.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+struct FiberStat
+{
+    int64_t seq_                = 0;
+    CodePos create_pos_;                //创建fiber时调用Create的位置
+    int64_t run_ns_             = 0;    //累计运行时间，单位纳秒
+    int64_t run_ns_max_         = 0;    //单次被调度后连续运行的最长时间，单位纳秒
+    int64_t switch_in_count_    = 0;    //被调度执行的次数
+};
+
+/*
+返回当前线程中累计运行时间最长的n个存活fiber的统计，按运行时间从大到小排列
+运行时间是调度器在每次切入切出时用单调时钟计量的，包含了fiber中阻塞在系统调用（如普通文件读写）上的时间
+*/
+GoSlice<FiberStat> TopFibersByRunTime(ssize_t n);
+
+/*
+启动看门狗线程，检测各调度线程中连续运行超过threshold_ms毫秒而没有切出的fiber（它会导致同线程的其他fiber全部停顿），
+检测到时向对应线程发送sig信号，由信号处理函数将该fiber的序号、创建位置和当前调用栈打印到标准错误输出，
+每次连续运行只报告一次
+看门狗是进程级别的，只能启动一次，sig的信号处理函数会被覆盖，应选择程序没有使用的信号
+*/
+bool StartFiberWatchdog(int64_t threshold_ms, int sig = SIGUSR2);
+
+}
+
+}
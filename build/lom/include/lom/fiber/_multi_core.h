@@ -0,0 +1,58 @@
+#pragma once
+
+#include "_listener.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+struct MultiCoreOptions
+{
+    //调度线程数，<=0表示每个可用的CPU一个线程
+    ssize_t thread_count_ = 0;
+
+    //是否将每个调度线程绑定到一个CPU
+    bool pin_cpu_ = true;
+
+    //>0时为每个调度线程准备好监听此TCP端口的Listener，0表示不监听
+    uint16_t listen_port_ = 0;
+
+    //为每个线程的listen socket设置SO_INCOMING_CPU为其绑定的CPU，仅在pin_cpu_为true且不共享listener时有效
+    bool incoming_cpu_ = true;
+
+    /*
+    为true时所有线程共享同一个listen socket（以EPOLLEXCLUSIVE注册），否则每个线程使用各自的SO_REUSEPORT socket
+    共享方式下忙的线程不会被分到新连接，负载更均衡，但是accept有竞争；SO_REUSEPORT方式下由内核按哈希分配连接，无竞争
+    */
+    bool shared_listener_ = false;
+};
+
+//调度线程的信息，传给每个线程的初始化函数
+struct CoreCtx
+{
+    ssize_t idx_            = -1;   //线程序号，范围[0, thread_count_)
+    ssize_t thread_count_   = 0;
+    int cpu_                = -1;   //绑定的CPU，-1表示未绑定
+    int numa_node_          = -1;   //绑定的CPU所在的NUMA节点，-1表示未知
+    Listener listener_;             //本线程的Listener，未设置listen_port_时Valid()为false
+};
+
+/*
+启动多个调度线程并在每个线程中运行fiber环境，每个线程一个独立的调度器，
+连接在哪个线程被accept就在哪个线程内处理完毕，不跨线程迁移，使用者应将per-core的状态也放在thread_local中
+    - CPU按NUMA节点顺序分配，相邻序号的线程尽量在同一个节点上，线程在绑定CPU之后才初始化fiber环境，
+      使得调度器的数据结构优先从本节点分配内存
+    - 线程数超过可用CPU数时循环分配
+init在每个线程初始化完成后以一个新fiber的方式执行，可在其中创建accept循环等
+调用线程会作为0号调度线程，成功时不返回，只在启动前的准备阶段出错时返回false，启动后的内部错误会直接Die
+*/
+bool RunMultiCore(std::function<void (const CoreCtx &ctx)> init, const MultiCoreOptions &opts = MultiCoreOptions());
+
+//返回当前线程在RunMultiCore中的序号，不是由RunMultiCore启动的线程返回-1
+ssize_t CurrCoreIdx();
+
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <signal.h>
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+开启当前调度线程的协作式抢占：
+    线程本地的定时器每隔半个时间片向本线程发送sig信号，信号处理函数检查当前fiber连续运行的时长，
+    超过slice_ms时设置让出标记，fiber在下一个安全点（MaybeYield、Conn的读写、Sem::Acquire）检查到标记后让出，
+    回到就绪队列，使同线程的其他fiber得到运行
+    调度器空闲（阻塞在epoll_wait中）时定时器暂停，下一次切入fiber时恢复，没有fiber运行时不会被信号唤醒
+由于只在安全点让出，不调用这些接口的纯计算循环需要自行定期调用MaybeYield
+sig的处理函数是进程级别的，会被覆盖，默认的SIGURG一般不被程序使用，且未处理时默认忽略
+重复调用会以新的参数重新开启
+*/
+bool EnablePreempt(int64_t slice_ms = 10, int sig = SIGURG);
+
+//关闭当前调度线程的协作式抢占
+void DisablePreempt();
+
+//安全点：当前fiber已用完时间片则让出，否则只有一次判断，不在fiber中时不做任何事
+void MaybeYield();
+
+//返回当前线程中fiber因用完时间片而让出的次数
+int64_t PreemptedCount();
+
+}
+
+}
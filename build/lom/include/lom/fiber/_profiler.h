@@ -0,0 +1,31 @@
+#pragma once
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+启动进程级别的采样profiler：通过ITIMER_PROF定时器按进程消耗的CPU时间每秒采样hz次，
+每次在收到SIGPROF的线程中记录当前调用栈和正在运行的fiber，最多记录sample_count_max个样本，之后的样本丢弃
+样本区在启动时按sample_count_max一次性申请，每个样本约0.5KB，默认值约占5MB，按默认频率可记录约100秒的单核CPU时间
+hz范围[1, 10000]，不在范围则调整至边界值
+SIGPROF的信号处理函数会被覆盖，profiler同时只能运行一个
+限制：信号处理函数中调用的backtrace不是异步信号安全的，若信号打断了持有unwinder或动态链接器内部锁的代码
+（如dlopen、dl_iterate_phdr、异常的栈展开），可能死锁，采样期间应避免这类操作
+*/
+bool StartProfiler(int64_t hz = 99, ssize_t sample_count_max = 10 * 1000);
+
+/*
+停止采样，返回folded格式的调用栈统计，可直接作为flamegraph.pl等工具的输入，每行格式为：
+    thread-<tid>;fiber-<seq>;<最外层帧>;...;<最内层帧> <样本数>
+不在fiber中（如在调度器中）的样本以sched代替fiber-<seq>
+帧使用backtrace_symbols的符号信息，没有导出符号的函数显示为“模块+偏移”，可用addr2line等工具离线解析
+profiler未启动时返回空串
+*/
+Str StopProfiler();
+
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../_internal.h"
+
+#include "../str.h"
+
+#include "_buf_io.h"
+
+namespace lom
+{
+
+namespace io
+{
+
+/*
+只读映射的文件，用于查找表、快照等读多写少的数据文件，内容直接以StrSlice视图访问，不拷贝到堆上
+视图在MmapFile对象（包括NewBufReader返回的对象持有的引用）存在期间有效
+注意：
+    - 访问未载入内存的页会触发缺页，由内核同步读盘，期间阻塞整个线程（包括其中所有fiber），
+      对延迟敏感的场景可在Open时预读，或通过Advise(kWillNeed)提前异步载入
+    - 映射期间文件被其他进程截断的话，访问被截掉的部分会产生SIGBUS，使用者需保证文件内容不被修改
+*/
+class MmapFile
+{
+public:
+
+    typedef std::shared_ptr<MmapFile> Ptr;
+
+    virtual ~MmapFile()
+    {
+    }
+
+    //madvise的访问模式提示
+    enum Advice
+    {
+        kNormal,
+        kSequential,
+        kRandom,
+        kWillNeed,
+        kDontNeed,
+        //使用透明大页（需内核支持文件映射的THP），减少大文件随机访问的TLB缺失
+        kHugePage,
+    };
+
+    //文件全部内容的视图，空文件返回空视图
+    virtual StrSlice Data() const = 0;
+
+    ssize_t Len() const
+    {
+        return Data().Len();
+    }
+
+    //返回从off开始长度为len的视图，len<0表示到文件末尾，范围的合法性由调用者保证（同StrSlice::Slice）
+    StrSlice Range(ssize_t off, ssize_t len = -1) const
+    {
+        auto data = Data();
+        return len < 0 ? data.Slice(off) : data.Slice(off, len);
+    }
+
+    /*
+    对从off开始长度为len的范围（len<0表示到文件末尾）设置访问模式提示，范围会被扩展到页对齐
+    成功返回true，失败返回false并设置错误信息和errno
+    */
+    virtual bool Advise(Advice advice, ssize_t off = 0, ssize_t len = -1) const = 0;
+
+    /*
+    创建读取从off开始长度为len的范围（len<0表示到文件末尾）的BufReader，和BufReader::New创建的对象相比：
+        数据全部视为已缓冲，Peek、ReadSlice返回的视图直接指向映射的内存，且在映射存在期间一直有效，
+        Peek的n超过剩余数据长度时直接返回剩余的数据，相当于读到了EOF
+    返回的对象持有映射的引用
+    */
+    virtual BufReader::Ptr NewBufReader(ssize_t off = 0, ssize_t len = -1) const = 0;
+
+    /*
+    打开并映射文件，populate为true时在映射时预读全部内容（MAP_POPULATE）
+    不小于2MB的文件的映射地址按2MB对齐，以便kHugePage生效
+    出错返回nullptr并设置错误信息和errno
+    */
+    static Ptr Open(const char *path, bool populate = false);
+};
+
+}
+
+}
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <unistd.h>
+
+#include "../_internal.h"
+
+#include "../err.h"
+#include "../str.h"
+
+namespace lom
+{
+
+namespace io
+{
+
+/*
+静态分派的带缓冲读写封装，和BufReader、BufWriter的区别：
+    下层读写对象的类型是模板参数，调用可以内联，不经过std::function和虚函数
+    缓冲是对象内的定长数组，对象可直接定义在栈上或作为成员，不需要在堆上申请
+Src需实现`ssize_t Read(char *buf, ssize_t sz)`，Sink需实现`ssize_t Write(const char *buf, ssize_t sz)`，
+语义分别同BufReader::DoReadFunc和BufWriter::DoWriteFunc，fiber::Conn满足此要求（使用默认的不超时）
+各方法的语义和返回值同BufReader和BufWriter的对应方法，区别是缓冲不会扩大，因此Peek的n不能超过kBufSize
+缓冲在对象内，较大的kBufSize不适合定义在fiber栈上
+*/
+template <typename Src, ssize_t kBufSize = 4096>
+class StaticBufReader
+{
+    static_assert(kBufSize > 0, "invalid buf size");
+
+    Src src_;
+    ssize_t start_ = 0;
+    ssize_t len_ = 0;
+    char buf_[kBufSize];
+
+    StaticBufReader(const StaticBufReader &) = delete;
+    StaticBufReader &operator=(const StaticBufReader &) = delete;
+
+    static ssize_t ErrInvalidSize()
+    {
+        SetErr("invalid size");
+        errno = EINVAL;
+        return -1;
+    }
+
+    //在已有数据之后读入更多数据，尾部没有空间时先将数据整理到头部，返回值同下层读函数
+    ssize_t FillMore()
+    {
+        if (len_ == 0)
+        {
+            start_ = 0;
+        }
+        else if (start_ + len_ == kBufSize)
+        {
+            memmove(buf_, buf_ + start_, len_);
+            start_ = 0;
+        }
+        ssize_t tail = start_ + len_;
+        Assert(tail < kBufSize);
+        ssize_t ret = src_.Read(buf_ + tail, kBufSize - tail);
+        if (ret > 0)
+        {
+            Assert(ret <= kBufSize - tail);
+            len_ += ret;
+        }
+        return ret;
+    }
+
+    void Consume(char *buf, ssize_t n)
+    {
+        memcpy(buf, buf_ + start_, n);
+        start_ += n;
+        len_ -= n;
+    }
+
+public:
+
+    explicit StaticBufReader(Src src) : src_(std::move(src))
+    {
+    }
+
+    Src &GetSrc()
+    {
+        return src_;
+    }
+
+    ssize_t Read(char *buf, ssize_t sz)
+    {
+        if (sz <= 0)
+        {
+            return ErrInvalidSize();
+        }
+        if (len_ == 0)
+        {
+            if (sz >= kBufSize)
+            {
+                return src_.Read(buf, sz);
+            }
+            ssize_t ret = FillMore();
+            if (ret <= 0)
+            {
+                return ret;
+            }
+        }
+        ssize_t copy_len = std::min(len_, sz);
+        Consume(buf, copy_len);
+        return copy_len;
+    }
+
+    ssize_t ReadUntil(char end_ch, char *buf, ssize_t sz)
+    {
+        if (sz <= 0)
+        {
+            return ErrInvalidSize();
+        }
+        for (ssize_t i = 0; i < sz;)
+        {
+            if (len_ == 0)
+            {
+                ssize_t ret = FillMore();
+                if (ret < 0)
+                {
+                    return ret;
+                }
+                if (ret == 0)
+                {
+                    //EOF
+                    return i;
+                }
+            }
+            ssize_t fill_len = std::min(len_, sz - i);
+            auto p = static_cast<const char *>(memchr(buf_ + start_, end_ch, static_cast<size_t>(fill_len)));
+            if (p != nullptr)
+            {
+                fill_len = p - (buf_ + start_) + 1;
+                Consume(buf + i, fill_len);
+                return i + fill_len;
+            }
+            Consume(buf + i, fill_len);
+            i += fill_len;
+        }
+        return sz;
+    }
+
+    ssize_t ReadFull(char *buf, ssize_t sz)
+    {
+        if (sz <= 0)
+        {
+            return ErrInvalidSize();
+        }
+        for (ssize_t i = 0; i < sz;)
+        {
+            ssize_t ret = Read(buf + i, sz - i);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            if (ret == 0)
+            {
+                //EOF
+                return i;
+            }
+            i += ret;
+        }
+        return sz;
+    }
+
+    ssize_t Peek(ssize_t n, StrSlice &s)
+    {
+        if (n <= 0 || n > kBufSize)
+        {
+            return ErrInvalidSize();
+        }
+        while (len_ < n)
+        {
+            if (start_ + n > kBufSize)
+            {
+                memmove(buf_, buf_ + start_, len_);
+                start_ = 0;
+            }
+            ssize_t ret = FillMore();
+            if (ret < 0)
+            {
+                return ret;
+            }
+            if (ret == 0)
+            {
+                //EOF
+                break;
+            }
+        }
+        s = StrSlice(buf_ + start_, std::min(len_, n));
+        return s.Len();
+    }
+
+    ssize_t Discard(ssize_t n)
+    {
+        if (n < 0)
+        {
+            return ErrInvalidSize();
+        }
+        ssize_t done = 0;
+        while (done < n)
+        {
+            if (len_ == 0)
+            {
+                ssize_t ret = FillMore();
+                if (ret < 0)
+                {
+                    return ret;
+                }
+                if (ret == 0)
+                {
+                    //EOF
+                    break;
+                }
+            }
+            ssize_t skip_len = std::min(len_, n - done);
+            start_ += skip_len;
+            len_ -= skip_len;
+            done += skip_len;
+        }
+        return done;
+    }
+
+    ssize_t Buffered() const
+    {
+        return len_;
+    }
+};
+
+//见StaticBufReader的说明，缓冲中的数据是连续的，满了才写出，WriteAll的数据不小于kBufSize时直接写下层
+template <typename Sink, ssize_t kBufSize = 4096>
+class StaticBufWriter
+{
+    static_assert(kBufSize > 0, "invalid buf size");
+
+    Sink sink_;
+    ssize_t len_ = 0;
+    char buf_[kBufSize];
+
+    StaticBufWriter(const StaticBufWriter &) = delete;
+    StaticBufWriter &operator=(const StaticBufWriter &) = delete;
+
+    int WriteToSink(const char *buf, ssize_t sz)
+    {
+        while (sz > 0)
+        {
+            ssize_t ret = sink_.Write(buf, sz);
+            if (ret < 0)
+            {
+                return static_cast<int>(ret);
+            }
+            Assert(ret > 0 && ret <= sz);
+            buf += ret;
+            sz -= ret;
+        }
+        return 0;
+    }
+
+public:
+
+    explicit StaticBufWriter(Sink sink) : sink_(std::move(sink))
+    {
+    }
+
+    Sink &GetSink()
+    {
+        return sink_;
+    }
+
+    int WriteAll(const char *buf, ssize_t sz)
+    {
+        if (sz < 0)
+        {
+            SetErr("negative size");
+            errno = EINVAL;
+            return -1;
+        }
+
+        if (sz <= kBufSize - len_)
+        {
+            memcpy(buf_ + len_, buf, sz);
+            len_ += sz;
+            return 0;
+        }
+
+        if (sz < kBufSize)
+        {
+            //先填满缓冲再写出
+            ssize_t copy_len = kBufSize - len_;
+            memcpy(buf_ + len_, buf, copy_len);
+            len_ = kBufSize;
+            buf += copy_len;
+            sz -= copy_len;
+            int ret = Flush();
+            if (ret != 0)
+            {
+                return ret;
+            }
+            memcpy(buf_, buf, sz);
+            len_ = sz;
+            return 0;
+        }
+
+        int ret = Flush();
+        if (ret != 0)
+        {
+            return ret;
+        }
+        return WriteToSink(buf, sz);
+    }
+
+    int Flush()
+    {
+        ssize_t done = 0;
+        while (done < len_)
+        {
+            ssize_t ret = sink_.Write(buf_ + done, len_ - done);
+            if (ret < 0)
+            {
+                //保留没写出的数据
+                memmove(buf_, buf_ + done, len_ - done);
+                len_ -= done;
+                return static_cast<int>(ret);
+            }
+            Assert(ret > 0 && ret <= len_ - done);
+            done += ret;
+        }
+        len_ = 0;
+        return 0;
+    }
+};
+
+//以原始fd为下层的读写对象，fd需为阻塞模式，被信号中断的系统调用会自动重试
+class RawFdIO
+{
+    int fd_;
+
+public:
+
+    explicit RawFdIO(int fd) : fd_(fd)
+    {
+    }
+
+    ssize_t Read(char *buf, ssize_t sz)
+    {
+        ssize_t ret;
+        do
+        {
+            ret = read(fd_, buf, static_cast<size_t>(sz));
+        } while (ret == -1 && errno == EINTR);
+        return ret;
+    }
+
+    ssize_t Write(const char *buf, ssize_t sz)
+    {
+        ssize_t ret;
+        do
+        {
+            ret = write(fd_, buf, static_cast<size_t>(sz));
+        } while (ret == -1 && errno == EINTR);
+        return ret;
+    }
+};
+
+//以一段内存为下层的读对象，内存需在使用期间保持有效
+class SliceReader
+{
+    StrSlice s_;
+
+public:
+
+    explicit SliceReader(StrSlice s) : s_(s)
+    {
+    }
+
+    ssize_t Read(char *buf, ssize_t sz)
+    {
+        ssize_t copy_len = std::min(sz, s_.Len());
+        memcpy(buf, s_.Data(), copy_len);
+        s_ = s_.Slice(copy_len);
+        return copy_len;
+    }
+};
+
+//追加到Str::Buf的写对象，buf需在使用期间保持有效
+class StrBufWriter
+{
+    Str::Buf *buf_;
+
+public:
+
+    explicit StrBufWriter(Str::Buf &buf) : buf_(&buf)
+    {
+    }
+
+    ssize_t Write(const char *buf, ssize_t sz)
+    {
+        buf_->Append(buf, sz);
+        return sz;
+    }
+};
+
+}
+
+}
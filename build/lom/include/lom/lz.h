@@ -0,0 +1,67 @@
+#pragma once
+
+#include "_internal.h"
+
+#include "str.h"
+#include "io/io.h"
+
+namespace lom
+{
+
+namespace lz
+{
+
+/*
+LZ77族的快速块压缩，格式和LZ4的块格式类似（不兼容），侧重速度，适合带宽受限的数据流，
+文本、日志、序列化结构等有重复内容的数据一般可压缩到原来的1/2到1/4
+
+块格式：由若干序列组成，每个序列为：
+    token（1字节，高4位为字面量长度，低4位为匹配长度-4，为15时后续有扩展长度字节，每字节累加，直到不为255）
+    字面量数据
+    匹配偏移（2字节小端，范围[1, 65535]）和匹配长度的扩展字节，最后一个序列只有字面量，没有这部分
+
+流格式（Compress和压缩过滤器的输出）：由若干块组成，每块为：
+    var_int::EncodeUInt(原长度) var_int::EncodeUInt(压缩后长度) 压缩数据
+    压缩后不变短的块直接存储原始数据，此时压缩后长度记为0
+    每块原长度不超过kBlockSizeMax，块之间独立
+*/
+
+static const ssize_t kBlockSizeMax = 4 * 1024 * 1024;
+
+//压缩块的输出长度上限，sz的范围[0, kBlockSizeMax]
+inline ssize_t CompressBound(ssize_t sz)
+{
+    return sz + sz / 255 + 16;
+}
+
+/*
+压缩一块数据，dst的空间需不小于CompressBound(src_len)，src_len的范围[0, kBlockSizeMax]
+返回压缩后的长度
+*/
+ssize_t CompressBlock(const char *src, ssize_t src_len, char *dst);
+
+/*
+解压一块数据到dst，dst_cap为dst的空间大小，返回解压后的长度
+数据格式错误或解压结果超过dst_cap时返回-1，不会读写给定范围以外的内存，但dst中超出结果长度的部分可能被改写
+*/
+ssize_t DecompressBlock(const char *src, ssize_t src_len, char *dst, ssize_t dst_cap);
+
+//一次性压缩和解压，使用流格式，解压失败时返回false并设置错误信息
+Str Compress(StrSlice s);
+bool Decompress(StrSlice s, Str &out);
+
+/*
+压缩过滤器，写入的数据按块大小积攒，压缩后写入bw，Flush时先压缩不满一块的数据，再调用bw的Flush
+block_sz会被调整到一个内部范围，指定<=0表示使用默认值，较小的块（或频繁Flush）会降低压缩率
+*/
+io::BufWriter::Ptr NewCompressWriter(io::BufWriter::Ptr bw, ssize_t block_sz = 0);
+
+/*
+解压过滤器，从br读取流格式的数据，解压后通过返回的BufReader提供，buf_sz含义同BufReader::New
+数据格式错误时读取接口返回-1并设置errno为EBADMSG，数据在块的中间结束也视为格式错误
+*/
+io::BufReader::Ptr NewDecompressReader(io::BufReader::Ptr br, ssize_t buf_sz = 0);
+
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../_internal.h"
+
+namespace lom
+{
+
+namespace math
+{
+
+//判断是否质数
+bool IsPrime(uint64_t n);
+
+}
+
+}
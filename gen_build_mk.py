@@ -49,9 +49,14 @@ for f, o in zip(files, objs):
 write_line("\t$(LOM_AR) $(LOM_AR_FLAGS) lom/lib/liblom.a %s" % " ".join(objs))
 
 for case in cases:
+    #用例目录下可以有一个extra_flags文件，其内容追加到编译选项之后，如用-std=gnu++20覆盖默认的标准
+    extra_flags = ""
+    extra_flags_path = "../test/%s/extra_flags" % case
+    if os.path.exists(extra_flags_path):
+        extra_flags = " " + " ".join(open(extra_flags_path).read().split())
     write_line(
-        "\t$(LOM_LD) $(LOM_CXX_FLAGS) $(LOM_LD_FLAGS) "
+        "\t$(LOM_LD) $(LOM_CXX_FLAGS)%s $(LOM_LD_FLAGS) "
         "-o test/%s ../test/%s/*.cpp lom/lib/liblom.a $(LIM_LD_STD_LIB_FLAGS)" %
-        (case, case))
+        (extra_flags, case, case))
 
 mkf.close()
@@ -8,6 +8,7 @@
 #include "lom/iter.h"
 #include "lom/limit.h"
 #include "lom/lru_cache.h"
+#include "lom/lz.h"
 #include "lom/mem.h"
 #include "lom/rand.h"
 #include "lom/str.h"
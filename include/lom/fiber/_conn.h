@@ -2,12 +2,59 @@
 
 #include "_fd.h"
 
+#include "../io/io.h"
+
 namespace lom
 {
 
 namespace fiber
 {
 
+/*
+连接的socket选项，字段值为负数表示不设置，即保持系统默认或继承的值
+TCP相关的选项只能用于TCP连接
+*/
+struct ConnSockOpts
+{
+    int no_delay_           = -1;   //TCP_NODELAY，0或1，注意建立或接收连接时若不指定，则默认会尝试开启
+    int snd_buf_            = -1;   //SO_SNDBUF
+    int rcv_buf_            = -1;   //SO_RCVBUF
+    int not_sent_low_at_    = -1;   //TCP_NOTSENT_LOWAT，限制发送缓冲中未发出的数据量，减少缓冲膨胀
+    int quick_ack_          = -1;   //TCP_QUICKACK，0或1，注意这个选项不是永久的，内核可能在之后自动关闭
+    int keep_alive_         = -1;   //SO_KEEPALIVE，0或1
+    int keep_idle_sec_      = -1;   //TCP_KEEPIDLE
+    int keep_intvl_sec_     = -1;   //TCP_KEEPINTVL
+    int keep_cnt_           = -1;   //TCP_KEEPCNT
+};
+
+/*
+连接的I/O统计，字段按读（r_）和写（w_）分别统计
+wait_count为因不可读写而进入等待的次数，包括系统调用返回EAGAIN和因已知不可读写而跳过系统调用的情况，
+wait_ns为这些等待的总时长
+*/
+struct ConnStats
+{
+    int fd_                         = -1;
+    int64_t enabled_at_ms_          = 0;    //开启统计的时间
+    int64_t r_bytes_                = 0;
+    int64_t w_bytes_                = 0;
+    int64_t r_sys_call_count_       = 0;
+    int64_t w_sys_call_count_       = 0;
+    int64_t r_wait_count_           = 0;
+    int64_t w_wait_count_           = 0;
+    int64_t r_wait_ns_              = 0;
+    int64_t w_wait_ns_              = 0;
+};
+
+/*
+设置当前线程是否默认对连接开启I/O统计，开启后通过FromRawFd、Accept、Connect系列接口新建的连接都会自动开启，
+默认为关闭，已有的连接不受影响
+*/
+void SetConnStatsEnabledByDefault(bool enabled);
+
+//返回当前线程中所有开启了统计的存活连接的统计快照，按fd排序
+GoSlice<ConnStats> AllConnStats();
+
 class Conn : public Fd
 {
 public:
@@ -41,6 +88,74 @@ public:
     */
     int WriteAll(const char *buf, ssize_t sz, int64_t timeout_ms = -1) const;
 
+    /*
+    通过writev写多段数据，iov_cnt范围[1, IOV_MAX]，语义和返回值同Write，sz为各段长度之和
+    */
+    ssize_t WriteV(const struct iovec *iov, int iov_cnt, int64_t timeout_ms = -1) const;
+
+    /*
+    读数据追加到cb尾部（读入cb尾部块的剩余空间或新的内存池的块），返回值同Read
+    */
+    ssize_t ReadToChainBuf(io::ChainBuf &cb, int64_t timeout_ms = -1) const;
+
+    /*
+    通过writev将cb中的数据全部写出，写出的数据从cb中移除，timeout_ms作用于每次writev调用
+    返回值同WriteAll，出错时cb中剩下的是还没写出的数据
+    */
+    int WriteAllFromChainBuf(io::ChainBuf &cb, int64_t timeout_ms = -1) const;
+
+    //单次SendFds或RecvFds能传递的最大fd数量，同内核的SCM_MAX_FD
+    static const ssize_t kFdCountMaxPerMsg = 253;
+
+    /*
+    通过Unix域socket连接发送数据并附带fd（SCM_RIGHTS），sz必须>0，fd_count范围[1, kFdCountMaxPerMsg]
+    fd是随着数据的第一个字节一起发送的，因此和Write一样允许数据部分成功，返回>0就表示fd都已发送，
+    发送后本地的fd依然有效，需要调用者自行关闭
+    返回值同Write
+    */
+    ssize_t SendFds(const char *buf, ssize_t sz, const int *fds, ssize_t fd_count, int64_t timeout_ms = -1) const;
+
+    /*
+    接收数据和对端附带的fd，sz必须>0，fds可容纳fd_count个fd，成功时fd_count被设置为实际收到的fd数量（可能为0）
+    收到的fd都设置了close-on-exec，由调用者负责使用（如通过Conn::FromRawFd注册）或关闭
+    若对端附带的fd数量超过了fds的容量，则本次收到的fd都会被关闭，并返回kOverflow
+    其余返回值同Read
+    */
+    ssize_t RecvFds(char *buf, ssize_t sz, int *fds, ssize_t &fd_count, int64_t timeout_ms = -1) const;
+
+    /*
+    将一个连接迁移给Unix域socket的对端（一般是另一个进程），成功后conn在本地被关闭
+    对端使用RecvConn接收，注意迁移只转移连接本身，conn上已被读入本地缓冲的数据需要使用者自行处理
+    返回0表示成功，其余返回值同WriteAll
+    */
+    int SendConn(Conn conn, int64_t timeout_ms = -1) const;
+
+    //接收对端通过SendConn迁移过来的连接，出错时返回的连接Valid()为false，若err_code不为nullptr，则将错误代码存入
+    Conn RecvConn(int64_t timeout_ms = -1, int *err_code = nullptr) const;
+
+    /*
+    对此连接开启I/O统计，统计数据跟随fd表项，连接被关闭或注销时释放，重复开启不影响已有的统计
+    未开启统计的连接在读写路径上只多一次判断
+    */
+    bool EnableStats() const;
+
+    //获取此连接的I/O统计，未开启统计时返回false
+    bool GetStats(ConnStats &stats) const;
+
+    //设置socket选项，按字段顺序逐个设置，遇到失败则返回false，之前设置成功的选项不会回滚
+    bool SetSockOpts(const ConnSockOpts &opts) const;
+
+    //开启或关闭TCP_CORK，关闭时会立即发出缓冲中的不完整数据包
+    bool SetCork(bool enable) const;
+
+    /*
+    创建以此连接为下层的BufReader和BufWriter，timeout_ms作用于每次下层读写调用
+    auto_cork为true时，BufWriter会在一次Flush之前因缓冲满而发生多次写操作的情况下开启TCP_CORK，
+    并在Flush完成时关闭，使得大的响应能被合并成尽量满的数据包发出，对于只需一次写操作的小响应则不做额外处理
+    */
+    io::BufReader::Ptr NewBufReader(ssize_t buf_sz = 0, int64_t timeout_ms = -1) const;
+    io::BufWriter::Ptr NewBufWriter(ssize_t buf_sz = 0, int64_t timeout_ms = -1, bool auto_cork = false) const;
+
     //从一个原始fd创建新的Conn对象，如果出错，其IsValid()为false
     static Conn FromRawFd(int fd);
 };
@@ -50,10 +165,13 @@ public:
     ip必须是标准的IPV4格式，不支持hostname
     port指定端口
     timeout_ms指定超时时间
+    opts若不为nullptr，则在发起连接前设置这些socket选项（缓冲大小等选项需要在建立连接前设置才能完全生效）
 返回连接对象，如果出错，连接对象IsValid()为false
 若err_code不为nullptr，则将错误代码存入
 */
-Conn ConnectTCP(const char *ipv4, uint16_t port, int64_t timeout_ms = -1, int *err_code = nullptr);
+Conn ConnectTCP(
+    const char *ipv4, uint16_t port, int64_t timeout_ms = -1, int *err_code = nullptr,
+    const ConnSockOpts *opts = nullptr);
 
 /*
 向本地Unix域的流式socket建立连接
@@ -40,8 +40,9 @@ protected:
     注册一个fd，初始化这个对象，只能由派生类调用
     由于新的Fd对象是无效的，因此对新对象也可以不判断Reg的返回值，而是判断注册之后的IsValid
     需要注意Reg只能被成功调用一次，若对一个合法Fd对象Reg，则失败，并且不会影响当前值
+    epoll_exclusive为true时以EPOLLEXCLUSIVE方式注册，仅用于被多个线程共享的listen fd，此时只关注可读事件
     */
-    bool Reg(int fd);
+    bool Reg(int fd, bool epoll_exclusive = false);
 
 public:
 
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../io/io.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+普通文件的封装
+普通文件不支持epoll，读写总是立即“就绪”但实际可能因磁盘I/O而阻塞，因此不能像Conn那样注册到调度器，
+File的操作在内核支持时通过当前线程的io_uring异步执行，否则通过Offload的线程池执行，
+执行期间当前fiber等待，不会阻塞线程中的其他fiber
+这个类是原始fd的简单值类型封装，不做注册和有效性跟踪，由使用者自行保证Close后不再使用
+所有操作都不支持超时，因为提交给内核或线程池的请求会引用调用者的缓冲
+*/
+class File
+{
+    int fd_ = -1;
+
+public:
+
+    int RawFd() const
+    {
+        return fd_;
+    }
+
+    bool Valid() const
+    {
+        return fd_ >= 0;
+    }
+
+    /*
+    在指定偏移读写数据，sz必须>=0，允许部分成功
+    返回值：
+        >=0：读写的字节数，读返回0表示文件结束（或sz为0）
+        -1：系统调用错误，可使用errno
+        <-1：err_code中定义的内部错误码
+    */
+    ssize_t PRead(char *buf, ssize_t sz, int64_t off) const;
+    ssize_t PWrite(const char *buf, ssize_t sz, int64_t off) const;
+
+    //在指定偏移写入全部数据，成功返回0，其余返回值含义同PWrite
+    int PWriteAll(const char *buf, ssize_t sz, int64_t off) const;
+
+    /*
+    同步文件数据到磁盘，data_only为true时相当于fdatasync
+    成功返回0，失败返回值含义同PWrite
+    */
+    int Fsync(bool data_only = false) const;
+
+    //为文件预分配空间，参数含义同fallocate系统调用，返回值同Fsync
+    int Fallocate(int64_t off, int64_t len, int mode = 0) const;
+
+    bool Close() const;
+
+    /*
+    创建从off开始顺序读写文件的BufReader和BufWriter，读写位置由返回的对象自行维护，
+    注意BufWriter需要显式Flush
+    */
+    io::BufReader::Ptr NewBufReader(int64_t off = 0, ssize_t buf_sz = 0) const;
+    io::BufWriter::Ptr NewBufWriter(int64_t off = 0, ssize_t buf_sz = 0) const;
+
+    //打开文件，flags和mode参数同open系统调用，如果出错，返回对象的Valid()为false
+    static File Open(const char *path, int flags, int mode = 0644);
+
+    static File FromRawFd(int fd);
+};
+
+/*
+禁止当前线程的File使用io_uring，只使用线程池，在当前线程第一次执行File操作前调用才能生效，不影响其他线程
+主要用于内核io_uring实现有问题或做对比测试的情况
+*/
+void DisableFileIOUring();
+
+//返回当前线程的File操作是否使用了io_uring，若当前线程还没执行过File操作，则会先做初始化
+bool IsFileIOUringUsed();
+
+}
+
+}
@@ -16,11 +16,18 @@ public:
     /*
     接收连接，返回连接对象，如果出错，连接对象IsValid()为false
     若err_code不为nullptr，则将错误代码存入
+    若opts不为nullptr，则对接收的连接设置这些socket选项，设置失败则关闭连接并返回错误
     */
-    Conn Accept(int64_t timeout_ms = -1, int *err_code = nullptr) const;
+    Conn Accept(int64_t timeout_ms = -1, int *err_code = nullptr, const ConnSockOpts *opts = nullptr) const;
 
     //从一个原始fd创建新的Listener对象，如果出错，其IsValid()为false
     static Listener FromRawFd(int fd);
+
+    /*
+    同FromRawFd，用于同一个listen fd被多个调度线程各自注册的情况（如多个线程共享一个监听端口），
+    注册时使用EPOLLEXCLUSIVE，新连接到来时只唤醒部分线程，避免所有线程同时醒来争抢accept
+    */
+    static Listener FromSharedRawFd(int fd);
 };
 
 /*
@@ -0,0 +1,40 @@
+#pragma once
+
+namespace lom
+{
+
+namespace fiber
+{
+
+struct OffloadStats
+{
+    int64_t queue_len_          = 0;    //当前排队等待执行的任务数
+    int64_t queue_len_max_      = 0;    //排队任务数的历史最大值
+    int64_t running_count_      = 0;    //正在执行的任务数
+    int64_t done_count_         = 0;    //已完成的任务总数
+    int64_t wait_us_total_      = 0;    //已完成任务的排队时间总和，单位微秒
+    int64_t run_us_total_       = 0;    //已完成任务的执行时间总和，单位微秒
+    int64_t run_us_max_         = 0;    //单个任务执行时间的最大值，单位微秒
+};
+
+/*
+设置后台线程池的线程数，线程池是进程级别的，在第一次调用Offload时启动，启动后再设置会失败
+线程数范围[1, 1024]，不在范围则调整至边界值，默认为16
+*/
+bool SetOffloadThreadCount(ssize_t thread_count);
+
+/*
+将可能阻塞的操作（如普通文件读写、fsync、getaddrinfo、大数据的压缩等）放到后台线程池中执行，
+当前fiber阻塞等待执行完成，期间当前线程的其他fiber正常调度，完成后通过调度器的epoll唤醒
+注意fn是在其他线程执行的，不能调用fiber的接口，也不能依赖thread_local数据（如lom的错误信息）
+由于fn可能引用当前fiber栈上的数据，因此等待过程不支持超时，直到fn执行完成才会返回
+返回0表示成功，否则返回err_code中的错误码
+*/
+int Offload(std::function<void ()> fn);
+
+//获取线程池的统计信息
+OffloadStats GetOffloadStats();
+
+}
+
+}
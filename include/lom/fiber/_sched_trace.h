@@ -0,0 +1,28 @@
+#pragma once
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+开启当前线程的调度事件记录，记录fiber的切入切出、等待原因（fd读写、sem、超时）、唤醒来源以及epoll_wait的起止
+事件记录在本线程的定长环形缓冲中，容量为capacity条，写满后覆盖最早的事件，重复开启会清空之前的记录
+未开启时各记录点的开销只是一次判断
+*/
+void StartSchedTrace(ssize_t capacity = 64 * 1024);
+
+//停止当前线程的调度事件记录，已记录的事件保留，可继续Dump
+void StopSchedTrace();
+
+/*
+将当前线程缓冲中的事件转为Chrome trace的JSON格式，可以在chrome://tracing或Perfetto中打开
+每个fiber以其序号作为一行（tid），行内的“run”表示fiber的运行区间，“wait”表示从开始等待到再次运行的区间，
+参数中给出了等待原因、唤醒来源以及从被唤醒到被调度执行的延迟，调度器的epoll_wait显示在tid为0的行
+*/
+Str DumpSchedTraceJSON();
+
+}
+
+}
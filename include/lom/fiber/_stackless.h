@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../code_pos.h"
+
+#include "_conn.h"
+#include "_sem.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+无栈任务的底层接口，用于在fiber调度器上实现C++20协程（见co.h），一般不直接使用
+无栈任务和fiber一样由调度器调度（有seq，参与运行统计、调度追踪等），但没有独立的栈：
+    调度到任务时调用其resume函数，函数返回即表示任务让出，
+    需要等待时先通过Wait*登记等待事件再返回，下次被调度即表示事件已发生或超时
+在无栈任务中调用fiber的阻塞接口（Conn的读写、Sem::Acquire、SleepMS等）是错误的
+*/
+namespace stackless
+{
+
+typedef void (*ResumeFunc)(void *arg);
+
+//创建无栈任务，之后每次调度都调用resume(arg)，直到任务通过Finish结束
+void Create(ResumeFunc resume, void *arg, CodePos _cp = CodePos());
+
+//判断当前是否在无栈任务中执行
+bool InTask();
+
+/*
+登记当前无栈任务的等待事件，expire_at为超时的绝对时间（ms），-1表示不超时
+WaitUntil(-1)表示不等待任何事件，让出后直接重新就绪
+每次让出前最多登记一次
+*/
+void WaitFdR(int fd, int64_t expire_at);
+void WaitFdW(int fd, int64_t expire_at);
+void WaitSem(Sem sem, int64_t expire_at);
+void WaitUntil(int64_t expire_at);
+
+//标记当前无栈任务结束，resume返回后任务被释放，不会再被调度
+void Finish();
+
+/*
+无阻塞地尝试一次读写，返回值同Conn::Read和Conn::Write，
+区别在于需要等待时不阻塞，而是将would_block设为true并返回0，调用者应登记等待后让出，被唤醒后重试
+*/
+ssize_t TryRead(Conn conn, char *buf, ssize_t sz, bool &would_block);
+ssize_t TryWrite(Conn conn, const char *buf, ssize_t sz, bool &would_block);
+
+/*
+尝试从有效的sem申请acquire_value，返回本次申请到的值，语义同Sem::Acquire的内部过程：
+没申请够时当前任务成为sem的申请者，已申请的部分由sem保留，之后继续申请，
+中途放弃（如超时）时需通过RestoreAcquiring将累计申请到的值返还
+*/
+uint64_t TryAcquire(Sem sem, uint64_t acquire_value);
+void RestoreAcquiring(Sem sem, uint64_t acquiring_value);
+
+//协程帧的内存池，按大小分级缓存在线程本地的空闲链表中，释放时需传入和申请时相同的大小
+void *AllocFrame(size_t sz);
+void FreeFrame(void *p, size_t sz);
+
+}
+
+}
+
+}
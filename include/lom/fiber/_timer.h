@@ -0,0 +1,48 @@
+#pragma once
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+定时器，到期时由调度器直接执行回调，不需要为每个定时器创建fiber，适合大量连接的空闲超时等场景
+回调不在任何fiber中执行，因此不能调用会阻塞当前fiber的接口（如Conn的读写、SleepMS、Sem::Acquire等），
+可以调用Conn::Close、Sem::Release、Create等非阻塞接口，需要阻塞操作时可在回调中Create新的fiber
+和fiber环境中的其他对象一样，定时器只能在创建它的线程中使用
+定时器在待触发期间由调度器持有，因此即便使用者不再持有Ptr，到期后也依然会执行回调
+*/
+class Timer
+{
+public:
+
+    typedef std::shared_ptr<Timer> Ptr;
+
+    virtual ~Timer()
+    {
+    }
+
+    /*
+    停止定时器，返回定时器在调用前是否处于待触发状态，对一次性定时器来说返回false表示回调已执行过或已停止
+    停止后可以通过Reset重新启动
+    */
+    virtual bool Stop() = 0;
+
+    /*
+    将定时器设置为从当前开始ms毫秒后触发，对已停止或已触发的定时器也有效，返回值同Stop
+    对于周期性的定时器，ms同时会作为之后的触发周期
+    推迟触发时间是O(1)的操作，因此可以在每次收到数据时Reset连接的空闲超时定时器
+    */
+    virtual bool Reset(int64_t ms) = 0;
+};
+
+//创建一次性定时器，ms毫秒后执行f
+Timer::Ptr AfterFunc(int64_t ms, std::function<void ()> f);
+
+//创建周期性定时器，每隔interval_ms毫秒执行一次f，interval_ms小于1时按1处理，直到被Stop
+Timer::Ptr NewTicker(int64_t interval_ms, std::function<void ()> f);
+
+}
+
+}
@@ -0,0 +1,470 @@
+#pragma once
+
+/*
+基于fiber调度器的C++20无栈协程接口，需单独包含，且编译单元需要以C++20编译（lom本身依然以C++17编译）
+协程任务通过Spawn交给当前线程的调度器，和普通fiber在同一个Run循环中调度，等待时同样登记到调度器的
+等待队列和epoll，例如：
+    co::Task<> Echo(Conn conn)
+    {
+        char buf[1024];
+        for (;;)
+        {
+            ssize_t ret = co_await co::Read(conn, buf, sizeof(buf));
+            if (ret <= 0 || co_await co::WriteAll(conn, buf, ret) != 0)
+            {
+                break;
+            }
+        }
+        conn.Close();
+    }
+    ...
+    co::Spawn(Echo(conn));
+协程帧从stackless::AllocFrame的线程本地内存池分配
+注意：协程中不能调用fiber的阻塞接口（Conn::Read、Sem::Acquire、fiber::SleepMS等），需使用这里的对应接口
+*/
+
+#if __cplusplus < 202002L
+#   error error: lom/fiber/co.h needs C++20
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+
+#include "fiber.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+namespace co
+{
+
+//Spawn出的顶层任务的上下文，记录下次调度时需要恢复的协程（调用链最内层正在等待的那个）
+struct TaskCtx
+{
+    std::coroutine_handle<> curr_;
+};
+
+inline thread_local TaskCtx *curr_task_ctx = nullptr;
+
+//调度器调度到任务时的入口
+inline void ResumeTask(void *arg)
+{
+    TaskCtx *ctx = static_cast<TaskCtx *>(arg);
+    curr_task_ctx = ctx;
+    //恢复后任务可能已结束，ctx随顶层协程帧被释放，不能再访问
+    ctx->curr_.resume();
+    curr_task_ctx = nullptr;
+}
+
+class PromiseBase
+{
+public:
+
+    std::coroutine_handle<> continuation_;
+
+    static void *operator new(size_t sz)
+    {
+        return stackless::AllocFrame(sz);
+    }
+
+    static void operator delete(void *p, size_t sz)
+    {
+        stackless::FreeFrame(p, sz);
+    }
+
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    //结束时直接切换到等待它的协程（对称转移），调用链再深也不会增长系统栈
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) const noexcept
+        {
+            return h.promise().continuation_;
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception()
+    {
+        std::terminate();
+    }
+};
+
+template <typename T>
+class Promise : public PromiseBase
+{
+    std::optional<T> v_;
+
+public:
+
+    void return_value(T v)
+    {
+        v_.emplace(std::move(v));
+    }
+
+    T Result()
+    {
+        return std::move(*v_);
+    }
+};
+
+template <>
+class Promise<void> : public PromiseBase
+{
+public:
+
+    void return_void()
+    {
+    }
+
+    void Result()
+    {
+    }
+};
+
+/*
+协程任务，创建后不立即执行，被co_await时才开始执行，执行完后恢复co_await它的协程并返回结果
+只能移动，不能复制，未被co_await就析构的任务直接销毁
+*/
+template <typename T = void>
+class Task
+{
+public:
+
+    struct promise_type : public Promise<T>
+    {
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+private:
+
+    std::coroutine_handle<promise_type> h_;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : h_(h)
+    {
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+public:
+
+    Task(Task &&other) noexcept : h_(other.h_)
+    {
+        other.h_ = nullptr;
+    }
+
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (h_)
+            {
+                h_.destroy();
+            }
+            h_ = other.h_;
+            other.h_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        if (h_)
+        {
+            h_.destroy();
+        }
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> h_;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) const noexcept
+            {
+                h_.promise().continuation_ = continuation;
+                return h_;
+            }
+
+            T await_resume() const
+            {
+                return h_.promise().Result();
+            }
+        };
+        return Awaiter{h_};
+    }
+};
+
+/*
+登记等待事件并让出当前任务，被调度器唤醒（事件发生或超时）后恢复
+kind为kNone时不等待任何事件，仅当expire_at>=0时等待超时
+*/
+struct WaitFor
+{
+    enum Kind
+    {
+        kNone,
+        kFdR,
+        kFdW,
+        kSem,
+    };
+
+    Kind kind_;
+    int fd_;
+    Sem sem_;
+    int64_t expire_at_;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) const
+    {
+        Assert(curr_task_ctx != nullptr);
+        switch (kind_)
+        {
+            case kNone:
+            {
+                stackless::WaitUntil(expire_at_);
+                break;
+            }
+            case kFdR:
+            {
+                stackless::WaitFdR(fd_, expire_at_);
+                break;
+            }
+            case kFdW:
+            {
+                stackless::WaitFdW(fd_, expire_at_);
+                break;
+            }
+            case kSem:
+            {
+                stackless::WaitSem(sem_, expire_at_);
+                break;
+            }
+        }
+        curr_task_ctx->curr_ = h;
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+};
+
+//Spawn使用的顶层协程，结束时通知调度器释放任务
+class RootTask
+{
+public:
+
+    struct promise_type : public PromiseBase
+    {
+        TaskCtx ctx_;
+
+        RootTask get_return_object()
+        {
+            return RootTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            stackless::Finish();
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+    };
+
+    std::coroutine_handle<promise_type> h_;
+
+    explicit RootTask(std::coroutine_handle<promise_type> h) : h_(h)
+    {
+    }
+};
+
+inline RootTask RunRootTask(Task<> task)
+{
+    co_await std::move(task);
+}
+
+/*
+将任务交给当前线程的调度器执行，之后和fiber一样被调度，任务结束后自动释放
+_cp为创建位置，用于运行统计和看门狗报告，一般不需要指定
+*/
+inline void Spawn(Task<> task, CodePos _cp = CodePos())
+{
+    RootTask root = RunRootTask(std::move(task));
+    TaskCtx *ctx = &root.h_.promise().ctx_;
+    ctx->curr_ = root.h_;
+    stackless::Create(ResumeTask, ctx, _cp);
+}
+
+#define LOM_FIBER_CO_INIT_EXPIRE_AT() int64_t expire_at = timeout_ms < 0 ? -1 : NowMS() + timeout_ms
+
+#define LOM_FIBER_CO_CHECK_EXPIRED() do {           \
+    if (expire_at >= 0 && expire_at <= NowMS()) {   \
+        SetErr("timeout");                          \
+        co_return err_code::kTimeout;               \
+    }                                               \
+} while (false)
+
+#define LOM_FIBER_CO_CHECK_CONN_VALID() do {        \
+    if (!conn.Valid()) {                            \
+        SetErr("conn closed by other task");        \
+        co_return err_code::kClosed;                \
+    }                                               \
+} while (false)
+
+//以下接口的参数和返回值同Conn、Sem的对应方法
+inline Task<ssize_t> Read(Conn conn, char *buf, ssize_t sz, int64_t timeout_ms = -1)
+{
+    LOM_FIBER_CO_INIT_EXPIRE_AT();
+    for (;;)
+    {
+        bool would_block;
+        ssize_t ret = stackless::TryRead(conn, buf, sz, would_block);
+        if (!would_block)
+        {
+            co_return ret;
+        }
+        LOM_FIBER_CO_CHECK_EXPIRED();
+        co_await WaitFor{WaitFor::kFdR, conn.RawFd(), Sem(), expire_at};
+        LOM_FIBER_CO_CHECK_CONN_VALID();
+    }
+}
+
+inline Task<ssize_t> Write(Conn conn, const char *buf, ssize_t sz, int64_t timeout_ms = -1)
+{
+    LOM_FIBER_CO_INIT_EXPIRE_AT();
+    for (;;)
+    {
+        bool would_block;
+        ssize_t ret = stackless::TryWrite(conn, buf, sz, would_block);
+        if (!would_block)
+        {
+            co_return ret;
+        }
+        LOM_FIBER_CO_CHECK_EXPIRED();
+        co_await WaitFor{WaitFor::kFdW, conn.RawFd(), Sem(), expire_at};
+        LOM_FIBER_CO_CHECK_CONN_VALID();
+    }
+}
+
+inline Task<int> WriteAll(Conn conn, const char *buf, ssize_t sz, int64_t timeout_ms = -1)
+{
+    LOM_FIBER_CO_INIT_EXPIRE_AT();
+    while (sz > 0)
+    {
+        bool would_block;
+        ssize_t ret = stackless::TryWrite(conn, buf, sz, would_block);
+        if (!would_block)
+        {
+            if (ret < 0)
+            {
+                co_return static_cast<int>(ret);
+            }
+            buf += ret;
+            sz -= ret;
+            continue;
+        }
+        LOM_FIBER_CO_CHECK_EXPIRED();
+        co_await WaitFor{WaitFor::kFdW, conn.RawFd(), Sem(), expire_at};
+        LOM_FIBER_CO_CHECK_CONN_VALID();
+    }
+    co_return 0;
+}
+
+inline Task<int> Acquire(Sem sem, uint64_t acquire_value = 1, int64_t timeout_ms = -1)
+{
+    if (!sem.Valid())
+    {
+        SetErr("invalid sem");
+        co_return err_code::kInvalid;
+    }
+    if (acquire_value == 0)
+    {
+        co_return 0;
+    }
+
+    LOM_FIBER_CO_INIT_EXPIRE_AT();
+    uint64_t done_value = 0;
+    for (;;)
+    {
+        done_value += stackless::TryAcquire(sem, acquire_value - done_value);
+        if (done_value == acquire_value)
+        {
+            co_return 0;
+        }
+        if (expire_at >= 0 && expire_at <= NowMS())
+        {
+            if (done_value > 0)
+            {
+                stackless::RestoreAcquiring(sem, done_value);
+            }
+            SetErr("timeout");
+            co_return err_code::kTimeout;
+        }
+        co_await WaitFor{WaitFor::kSem, -1, sem, expire_at};
+        if (!sem.Valid())
+        {
+            SetErr("sem destroyed by another task");
+            co_return err_code::kClosed;
+        }
+    }
+}
+
+#undef LOM_FIBER_CO_INIT_EXPIRE_AT
+#undef LOM_FIBER_CO_CHECK_EXPIRED
+#undef LOM_FIBER_CO_CHECK_CONN_VALID
+
+//Sem::Release不会阻塞，协程中直接调用即可
+
+inline WaitFor SleepMS(int64_t ms)
+{
+    return WaitFor{WaitFor::kNone, -1, Sem(), ms > 0 ? NowMS() + ms : -1};
+}
+
+inline WaitFor Yield()
+{
+    return WaitFor{WaitFor::kNone, -1, Sem(), -1};
+}
+
+}
+
+}
+
+}
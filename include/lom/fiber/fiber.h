@@ -7,6 +7,18 @@
 #include "_conn.h"
 #include "_listener.h"
 #include "_sem.h"
+#include "_conn_pool.h"
+#include "_offload.h"
+#include "_file.h"
+#include "_multi_core.h"
+#include "_fiber_local.h"
+#include "_timer.h"
+#include "_fiber_stat.h"
+#include "_sched_trace.h"
+#include "_profiler.h"
+#include "_stackless.h"
+#include "_preempt.h"
+#include "_async_buf_writer.h"
 
 namespace lom
 {
@@ -27,8 +39,9 @@ void MustInit();    //init or die
 创建新的fiber
 run为入口函数
 stk_sz指定栈大小，不在范围则调整至边界值
+_cp为创建位置，用于运行统计和看门狗报告，一般不需要指定
 */
-void Create(std::function<void ()> run, ssize_t stk_sz = kStkSizeMin);
+void Create(std::function<void ()> run, ssize_t stk_sz = kStkSizeMin, CodePos _cp = CodePos());
 
 //开始运行，除非出现内部错误，否则永远不退出
 void Run();
@@ -36,6 +49,9 @@ void Run();
 void Yield();
 int SleepMS(int64_t ms);
 
+//返回当前线程中因fd已知不可读写而跳过的I/O系统调用的次数
+int64_t SkippedIOSysCallCount();
+
 }
 
 }
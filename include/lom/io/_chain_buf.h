@@ -0,0 +1,150 @@
+#pragma once
+
+#include <deque>
+
+#include "../_internal.h"
+
+#include "../str.h"
+
+#include "_buf_io.h"
+
+namespace lom
+{
+
+namespace io
+{
+
+/*
+由多个引用计数的数据段组成的链式缓冲，用于在连接、解析和转发之间传递数据而不做拷贝
+每个段引用一块底层存储的一部分，存储有两种：
+    - 内存池中的定长块，用于追加拷贝的小数据和从下层读入的数据，块在线程本地缓存复用
+    - 被接管的Str，长串只增加引用计数，不拷贝数据
+Split等操作产生的多个段可以共享同一块存储，存储在没有段引用时释放
+只能移动，不能复制，和fiber环境的其他对象一样，不能跨线程使用
+*/
+class ChainBuf
+{
+    struct Seg
+    {
+        std::shared_ptr<const char> p_;
+        ssize_t len_;
+
+        //数据之后可追加写入的空间，只有内存池的块的最后一段才可能不为0
+        ssize_t avail_;
+    };
+
+    std::deque<Seg> segs_;
+    ssize_t len_ = 0;
+
+    ChainBuf(const ChainBuf &) = delete;
+    ChainBuf &operator=(const ChainBuf &) = delete;
+
+    //返回尾部可追加写入的段，没有则新建一个内存池的块
+    Seg &TailSpace();
+
+    //从头部移除n字节，out不为nullptr时将移除的数据段追加到out
+    void PopFront(ssize_t n, ChainBuf *out);
+
+public:
+
+    //内存池的块大小
+    static const ssize_t kBlockSize = 8 * 1024;
+
+    //Append和Prepend接管Str时，短于这个长度的直接拷贝
+    static const ssize_t kAdoptLenMin = 512;
+
+    //单次WriteTo最多合并的段数
+    static const int kIovCountMax = 64;
+
+    ChainBuf()
+    {
+    }
+
+    ChainBuf(ChainBuf &&other) : segs_(std::move(other.segs_)), len_(other.len_)
+    {
+        other.segs_.clear();
+        other.len_ = 0;
+    }
+
+    ChainBuf &operator=(ChainBuf &&other)
+    {
+        if (this != &other)
+        {
+            segs_ = std::move(other.segs_);
+            len_ = other.len_;
+            other.segs_.clear();
+            other.len_ = 0;
+        }
+        return *this;
+    }
+
+    ssize_t Len() const
+    {
+        return len_;
+    }
+
+    ssize_t SegCount() const
+    {
+        return static_cast<ssize_t>(segs_.size());
+    }
+
+    void Clear()
+    {
+        segs_.clear();
+        len_ = 0;
+    }
+
+    //追加数据，StrSlice会被拷贝到内存池的块中，Str（包括由Str::Buf转换而来的）则被接管，other被清空
+    void Append(StrSlice s);
+    void Append(Str s);
+    void Append(Str::Buf &&buf)
+    {
+        Append(Str(std::move(buf)));
+    }
+    void Append(ChainBuf &&other);
+
+    //在头部插入数据，规则同Append
+    void Prepend(StrSlice s);
+    void Prepend(Str s);
+    void Prepend(ChainBuf &&other);
+
+    //移除并返回头部的n字节，n的范围[0, Len()]，边界处的段由两边共享存储
+    ChainBuf Split(ssize_t n);
+
+    //丢弃头部的n字节，n的范围[0, Len()]
+    void Discard(ssize_t n);
+
+    /*
+    保证头部的n字节在一段连续的内存中，返回其视图，n的范围[0, Len()]，不指定则为全部数据
+    已经连续时不拷贝，否则将这部分数据合并拷贝到一块新的存储中，视图在下一次修改本对象前有效
+    */
+    StrSlice Coalesce(ssize_t n);
+    StrSlice Coalesce()
+    {
+        return Coalesce(len_);
+    }
+
+    //拷贝出全部数据
+    Str ToStr() const;
+
+    //将头部最多iov_cnt_max个段填入iov，返回填入的个数
+    int FillIovecs(struct iovec *iov, int iov_cnt_max) const;
+
+    /*
+    通过下层读函数读入数据追加到尾部，读入尾部块的剩余空间或新的内存池的块，返回值同下层读函数
+    */
+    ssize_t ReadFrom(const BufReader::DoReadFunc &do_read);
+
+    /*
+    通过下层批量写函数将头部的数据（最多kIovCountMax段）写出一次，写出的数据从头部移除
+    没有数据时直接返回0，否则返回值同下层批量写函数
+    */
+    ssize_t WriteTo(const BufWriter::DoWriteVFunc &do_writev);
+
+    //反复调用WriteTo直到全部写完，返回0表示成功，否则返回负数表示出错，已写出的数据已被移除
+    int WriteAllTo(const BufWriter::DoWriteVFunc &do_writev);
+};
+
+}
+
+}
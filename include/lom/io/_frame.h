@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../_internal.h"
+
+#include "../str.h"
+
+#include "_buf_io.h"
+
+namespace lom
+{
+
+namespace io
+{
+
+struct FrameOptions
+{
+    enum Kind
+    {
+        //定长的长度前缀（大端），后跟帧数据
+        kLenPrefix,
+        //var_int编码（EncodeUInt）的长度前缀，后跟帧数据
+        kVarIntLenPrefix,
+        //帧数据后跟分隔符，帧数据中不能出现分隔符
+        kDelim,
+    };
+
+    Kind kind_ = kVarIntLenPrefix;
+
+    //kLenPrefix的前缀字节数，只能是1、2、4、8
+    int len_prefix_sz_ = 4;
+
+    //kDelim的分隔符，不能为空
+    Str delim_ = "\n";
+
+    //帧数据的最大长度（不含长度前缀和分隔符），超过视为出错，防止异常数据导致缓冲无限扩大
+    ssize_t frame_len_max_ = 64 * 1024 * 1024;
+};
+
+/*
+基于BufReader的帧解码，用于流水线（pipelining）的协议：客户端连续发出多个请求，服务端批量处理
+帧数据以视图的形式返回，不拷贝，视图在下一次调用本对象的方法前有效，期间不能直接操作下层的BufReader
+各方法返回值：>0表示解出的帧数，0表示在帧边界处读到EOF，<0表示出错，
+其中数据格式错误、帧过长、帧不完整时读到EOF会返回-1并分别设置errno为EBADMSG、EMSGSIZE、EBADMSG
+*/
+class FrameReader
+{
+public:
+
+    typedef std::shared_ptr<FrameReader> Ptr;
+
+    virtual ~FrameReader()
+    {
+    }
+
+    typedef std::function<void (StrSlice frame)> OnFrameFunc;
+
+    //读取一帧，成功时返回1
+    virtual ssize_t Read(StrSlice &frame) = 0;
+
+    /*
+    读取一批帧：先读到至少一个完整的帧，然后继续解出缓冲中已有的所有完整的帧，不再调用下层读函数，
+    对每个帧按顺序调用on_frame，返回帧数
+    这样客户端流水线发来的请求一般只需一次下层读调用即可全部取出
+    */
+    virtual ssize_t ReadBatch(const OnFrameFunc &on_frame) = 0;
+
+    //参数不合法的opts会导致Assert失败
+    static Ptr New(BufReader::Ptr br, const FrameOptions &opts = FrameOptions());
+};
+
+/*
+基于BufWriter的帧编码，Write只将编码后的帧写入BufWriter，由调用者在一批帧之后调用Flush，
+从而将一批响应合并为尽量少的下层写调用
+kDelim格式不检查帧数据中是否含有分隔符，由调用者保证
+各方法返回0表示成功，否则返回负数表示出错，帧过长返回-1并设置errno为EMSGSIZE
+*/
+class FrameWriter
+{
+public:
+
+    typedef std::shared_ptr<FrameWriter> Ptr;
+
+    virtual ~FrameWriter()
+    {
+    }
+
+    virtual int Write(StrSlice frame) = 0;
+    virtual int Flush() = 0;
+
+    //参数不合法的opts会导致Assert失败
+    static Ptr New(BufWriter::Ptr bw, const FrameOptions &opts = FrameOptions());
+};
+
+}
+
+}
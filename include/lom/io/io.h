@@ -3,6 +3,10 @@
 #include "../_internal.h"
 
 #include "_buf_io.h"
+#include "_static_buf_io.h"
+#include "_chain_buf.h"
+#include "_frame.h"
+#include "_mmap_file.h"
 
 namespace lom
 {
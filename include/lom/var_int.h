@@ -29,6 +29,12 @@ Decode函数在成功时会调整p和sz，消费掉本次解码的长度
 bool Decode(const char *&p, ssize_t &sz, int64_t &n);
 bool DecodeUInt(const char *&p, ssize_t &sz, uint64_t &n);
 
+/*
+根据编码的第一个字节返回整个编码的长度，第一个字节不合法时返回-1
+可用于在数据不完整时判断还需要多少字节，长度合法不代表编码合法，最终以Decode的结果为准
+*/
+ssize_t EncodedLen(char first_byte);
+
 //从buf reader中读取
 bool LoadFrom(const io::BufReader::Ptr &br, int64_t &n);
 bool LoadUIntFrom(const io::BufReader::Ptr &br, uint64_t &n);
@@ -0,0 +1,241 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+//生产者和后台fiber共享的状态，后台fiber持有引用，因此writer对象销毁后依然能写完剩余的数据
+struct AsyncBufWriterState
+{
+    enum FlusherStat
+    {
+        kBusy,
+        kIdle,      //等待新数据
+        kDelaying,  //组提交的等待
+    };
+
+    io::BufWriter::DoWriteFunc do_write_;
+    io::BufWriter::DoWriteVFunc do_writev_;
+    AsyncBufWriterOptions opts_;
+
+    //生产者写入active_，后台fiber将其整个换到flushing_中写出
+    io::ChainBuf active_;
+    io::ChainBuf flushing_;
+
+    //累计写入和累计写出（包括出错后丢弃的）的数据量，二者之差为积压
+    int64_t appended_total_ = 0;
+    int64_t flushed_total_ = 0;
+
+    int err_ = 0;
+    bool closed_ = false;
+
+    FlusherStat flusher_stat_ = kBusy;
+    Sem data_sem_;
+
+    /*
+    等待写出进度的生产者（反压或Flush）各自的sem，每一轮写出后全部唤醒，各自重新检查条件
+    不共用一个sem，否则先被唤醒的生产者再次等待时会抢走释放给其他生产者的值
+    */
+    std::vector<Sem> progress_waiters_;
+    ssize_t flush_waiting_count_ = 0;
+
+    int64_t Backlog() const
+    {
+        return appended_total_ - flushed_total_;
+    }
+
+    //唤醒后台fiber，urgent为false时不打断组提交的等待
+    void WakeFlusher(bool urgent)
+    {
+        if (flusher_stat_ == kIdle || (urgent && flusher_stat_ == kDelaying))
+        {
+            flusher_stat_ = kBusy;
+            data_sem_.Release();
+        }
+    }
+
+    int WaitProgress()
+    {
+        Sem sem = Sem::New(0);
+        progress_waiters_.emplace_back(sem);
+        int ret = sem.Acquire();
+        sem.Destroy();
+        return ret;
+    }
+
+    void NotifyProgress()
+    {
+        for (auto const &sem : progress_waiters_)
+        {
+            sem.Release();
+        }
+        progress_waiters_.clear();
+    }
+
+    //将flushing_全部写出，没有批量写函数时每次只写第一段
+    int WriteOut()
+    {
+        io::BufWriter::DoWriteVFunc do_writev = do_writev_;
+        if (!do_writev)
+        {
+            do_writev = [this] (const struct iovec *iov, int iov_cnt) -> ssize_t {
+                Assert(iov_cnt > 0);
+                return do_write_(static_cast<const char *>(iov[0].iov_base), static_cast<ssize_t>(iov[0].iov_len));
+            };
+        }
+        if (opts_.offload_)
+        {
+            //写出期间flushing_不会被其他fiber修改，iov引用的数据在Offload返回前一直有效
+            auto inner = std::move(do_writev);
+            do_writev = [&inner] (const struct iovec *iov, int iov_cnt) -> ssize_t {
+                ssize_t ret = 0;
+                int err = Offload(
+                    [&ret, &inner, iov, iov_cnt] () {
+                        ret = inner(iov, iov_cnt);
+                    }
+                );
+                return err != 0 ? err : ret;
+            };
+        }
+        return flushing_.WriteAllTo(do_writev);
+    }
+
+    void RunFlusher()
+    {
+        for (;;)
+        {
+            if (active_.Len() == 0)
+            {
+                if (closed_)
+                {
+                    break;
+                }
+                flusher_stat_ = kIdle;
+                data_sem_.Acquire();
+                flusher_stat_ = kBusy;
+                continue;
+            }
+
+            if (opts_.flush_delay_ms_ > 0 && !closed_ && flush_waiting_count_ == 0 && Backlog() < opts_.low_watermark_)
+            {
+                flusher_stat_ = kDelaying;
+                data_sem_.Acquire(1, opts_.flush_delay_ms_);
+                flusher_stat_ = kBusy;
+            }
+
+            flushing_ = std::move(active_);
+            auto len = flushing_.Len();
+            if (err_ == 0)
+            {
+                int ret = WriteOut();
+                if (ret != 0)
+                {
+                    err_ = ret;
+                }
+            }
+            flushing_.Clear();
+            flushed_total_ += len;
+            NotifyProgress();
+        }
+
+        data_sem_.Destroy();
+    }
+};
+
+class AsyncBufWriter : public io::BufWriter
+{
+    std::shared_ptr<AsyncBufWriterState> st_;
+
+public:
+
+    explicit AsyncBufWriter(std::shared_ptr<AsyncBufWriterState> st) : st_(st)
+    {
+    }
+
+    virtual ~AsyncBufWriter()
+    {
+        st_->closed_ = true;
+        st_->WakeFlusher(true);
+    }
+
+    virtual int WriteAll(const char *buf, ssize_t sz) override
+    {
+        if (sz < 0)
+        {
+            SetErr("negative size");
+            errno = EINVAL;
+            return -1;
+        }
+        if (st_->err_ != 0)
+        {
+            return st_->err_;
+        }
+        if (sz == 0)
+        {
+            return 0;
+        }
+
+        st_->active_.Append(StrSlice(buf, sz));
+        st_->appended_total_ += sz;
+        //积压达到低水位时不再等待组提交，否则反压中的生产者要多等一个flush_delay_ms_
+        st_->WakeFlusher(st_->Backlog() >= st_->opts_.low_watermark_);
+
+        if (st_->Backlog() >= st_->opts_.high_watermark_)
+        {
+            while (st_->Backlog() > st_->opts_.low_watermark_ && st_->err_ == 0)
+            {
+                int ret = st_->WaitProgress();
+                if (ret != 0)
+                {
+                    return ret;
+                }
+            }
+        }
+        return st_->err_;
+    }
+
+    virtual int Flush() override
+    {
+        int64_t target = st_->appended_total_;
+        while (st_->flushed_total_ < target && st_->err_ == 0)
+        {
+            st_->WakeFlusher(true);
+            ++ st_->flush_waiting_count_;
+            int ret = st_->WaitProgress();
+            -- st_->flush_waiting_count_;
+            if (ret != 0)
+            {
+                return ret;
+            }
+        }
+        return st_->err_;
+    }
+};
+
+io::BufWriter::Ptr NewAsyncBufWriter(
+    io::BufWriter::DoWriteFunc do_write, const AsyncBufWriterOptions &opts, io::BufWriter::DoWriteVFunc do_writev)
+{
+    AssertInited();
+
+    auto st = std::make_shared<AsyncBufWriterState>();
+    st->do_write_ = do_write;
+    st->do_writev_ = do_writev;
+    st->opts_ = opts;
+    st->opts_.high_watermark_ = std::max<ssize_t>(st->opts_.high_watermark_, 1);
+    st->opts_.low_watermark_ = std::min(std::max<ssize_t>(st->opts_.low_watermark_, 0), st->opts_.high_watermark_);
+    st->data_sem_ = Sem::New(0);
+
+    Create(
+        [st] () {
+            st->RunFlusher();
+        }
+    );
+
+    return io::BufWriter::Ptr(new AsyncBufWriter(st));
+}
+
+}
+
+}
@@ -8,6 +8,16 @@ namespace fiber
 
 #define LOM_FIBER_CONN_INIT_EXPIRE_AT() int64_t expire_at = timeout_ms < 0 ? -1 : NowMS() + timeout_ms
 
+/*
+更新连接的I/O统计，未开启统计时只有一次判断，_field为ConnStats的字段名
+*/
+#define LOM_FIBER_CONN_STATS_ADD(_field, _v) do {                   \
+    ConnStats *_stats = GetFdInfo(conn.RawFd()).stats_;             \
+    if (_stats != nullptr) {                                        \
+        _stats->_field += (_v);                                     \
+    }                                                               \
+} while (false)
+
 #define LOM_FIBER_CONN_ON_IO_SYS_CALL_ERR(_r_or_w) do {             \
     Assert(ret == -1 && errno != 0);                                \
     if (errno == ECONNRESET) {                                      \
@@ -26,6 +36,14 @@ namespace fiber
         return err_code::kTimeout;                                  \
     }                                                               \
     if (errno == EAGAIN) {                                          \
+        LOM_SDT_PROBE1(conn_eagain_##_r_or_w, conn.RawFd());        \
+        FdInfo &_fd_info = GetFdInfo(conn.RawFd());                 \
+        _fd_info._r_or_w##_ready_ = false;                          \
+        int64_t _wait_begin_at = 0;                                 \
+        if (_fd_info.stats_ != nullptr) {                           \
+            ++ _fd_info.stats_->_r_or_w##_wait_count_;              \
+            _wait_begin_at = NowClockNS();                          \
+        }                                                           \
         WaitingEvents evs;                                          \
         evs.expire_at_ = expire_at;                                 \
         evs.waiting_fds_##_r_or_w##_.emplace_back(conn.RawFd());    \
@@ -34,11 +52,47 @@ namespace fiber
             SetError("conn closed by other fiber");                 \
             return err_code::kClosed;                               \
         }                                                           \
+        if (_wait_begin_at > 0) {                                   \
+            LOM_FIBER_CONN_STATS_ADD(                               \
+                _r_or_w##_wait_ns_, NowClockNS() - _wait_begin_at); \
+        }                                                           \
     }                                                               \
 } while (false)
 
+/*
+执行I/O系统调用，若fd已知不可读写，则跳过系统调用并模拟其返回EAGAIN，从而直接进入等待
+*/
+#define LOM_FIBER_CONN_DO_IO_SYS_CALL(_r_or_w, _sys_call) (    \
+    GetFdInfo(conn.RawFd())._r_or_w##_ready_ ?                  \
+        (OnConnIOSysCall(conn.RawFd(),                          \
+                         &ConnStats::_r_or_w##_sys_call_count_),\
+         (ssize_t)(_sys_call)) :                                \
+        (OnIOSysCallSkipped(), errno = EAGAIN, (ssize_t)-1)     \
+)
+
+static void OnConnIOSysCall(int fd, int64_t ConnStats::*sys_call_count)
+{
+    ConnStats *stats = GetFdInfo(fd).stats_;
+    if (stats != nullptr)
+    {
+        ++ (stats->*sys_call_count);
+    }
+}
+
+//读取没有读满请求的长度时调用，流式fd没读满说明接收缓冲已经被读空，之后有新数据到来时会有新的epoll事件
+static void OnShortRead(int fd)
+{
+    FdInfo &fd_info = GetFdInfo(fd);
+    if (fd_info.stream_ && !fd_info.hup_)
+    {
+        fd_info.r_ready_ = false;
+    }
+}
+
 static ssize_t InternalRead(Conn conn, char *buf, ssize_t sz, int64_t expire_at)
 {
+    MaybeYield();
+
     if (!conn.Valid())
     {
         SetError("invalid conn");
@@ -47,9 +101,15 @@ static ssize_t InternalRead(Conn conn, char *buf, ssize_t sz, int64_t expire_at)
 
     for (;;)
     {
-        ssize_t ret = read(conn.RawFd(), buf, (size_t)sz);
+        ssize_t ret = LOM_FIBER_CONN_DO_IO_SYS_CALL(r, read(conn.RawFd(), buf, (size_t)sz));
         if (ret >= 0)
         {
+            LOM_SDT_PROBE3(conn_read, conn.RawFd(), sz, ret);
+            LOM_FIBER_CONN_STATS_ADD(r_bytes_, ret);
+            if (ret > 0 && ret < sz)
+            {
+                OnShortRead(conn.RawFd());
+            }
             return ret;
         }
         LOM_FIBER_CONN_ON_IO_SYS_CALL_ERR(r);
@@ -58,6 +118,8 @@ static ssize_t InternalRead(Conn conn, char *buf, ssize_t sz, int64_t expire_at)
 
 static ssize_t InternalWrite(Conn conn, const char *buf, ssize_t sz, int64_t expire_at)
 {
+    MaybeYield();
+
     if (!conn.Valid())
     {
         SetError("invalid conn");
@@ -68,9 +130,63 @@ static ssize_t InternalWrite(Conn conn, const char *buf, ssize_t sz, int64_t exp
     {
         for (;;)
         {
-            ssize_t ret = write(conn.RawFd(), buf, (size_t)sz);
+            ssize_t ret = LOM_FIBER_CONN_DO_IO_SYS_CALL(w, write(conn.RawFd(), buf, (size_t)sz));
             if (ret > 0)
             {
+                LOM_SDT_PROBE3(conn_write, conn.RawFd(), sz, ret);
+                LOM_FIBER_CONN_STATS_ADD(w_bytes_, ret);
+                if (ret < sz)
+                {
+                    //没写完说明发送缓冲已满，之后腾出空间时会有新的epoll事件
+                    GetFdInfo(conn.RawFd()).w_ready_ = false;
+                }
+                return ret;
+            }
+            if (ret == 0)
+            {
+                if (expire_at >= 0 && expire_at <= NowMS())
+                {
+                    SetError("timeout");
+                    return err_code::kTimeout;
+                }
+                continue;
+            }
+            LOM_FIBER_CONN_ON_IO_SYS_CALL_ERR(w);
+        }
+    }
+
+    return 0;
+}
+
+static ssize_t InternalWriteV(Conn conn, const struct iovec *iov, int iov_cnt, int64_t expire_at)
+{
+    MaybeYield();
+
+    if (!conn.Valid())
+    {
+        SetError("invalid conn");
+        return err_code::kInvalid;
+    }
+
+    ssize_t sz = 0;
+    for (int i = 0; i < iov_cnt; ++ i)
+    {
+        sz += static_cast<ssize_t>(iov[i].iov_len);
+    }
+
+    if (sz > 0)
+    {
+        for (;;)
+        {
+            ssize_t ret = LOM_FIBER_CONN_DO_IO_SYS_CALL(w, writev(conn.RawFd(), iov, iov_cnt));
+            if (ret > 0)
+            {
+                LOM_SDT_PROBE3(conn_write, conn.RawFd(), sz, ret);
+                LOM_FIBER_CONN_STATS_ADD(w_bytes_, ret);
+                if (ret < sz)
+                {
+                    GetFdInfo(conn.RawFd()).w_ready_ = false;
+                }
                 return ret;
             }
             if (ret == 0)
@@ -91,6 +207,8 @@ static ssize_t InternalWrite(Conn conn, const char *buf, ssize_t sz, int64_t exp
 
 static int InternalWriteAll(Conn conn, const char *buf, ssize_t sz, int64_t expire_at)
 {
+    MaybeYield();
+
     if (!conn.Valid())
     {
         SetError("invalid conn");
@@ -99,10 +217,16 @@ static int InternalWriteAll(Conn conn, const char *buf, ssize_t sz, int64_t expi
 
     while (sz > 0)
     {
-        ssize_t ret = write(conn.RawFd(), buf, (size_t)sz);
+        ssize_t ret = LOM_FIBER_CONN_DO_IO_SYS_CALL(w, write(conn.RawFd(), buf, (size_t)sz));
         if (ret > 0)
         {
+            LOM_SDT_PROBE3(conn_write, conn.RawFd(), sz, ret);
+            LOM_FIBER_CONN_STATS_ADD(w_bytes_, ret);
             Assert(ret <= sz);
+            if (ret < sz)
+            {
+                GetFdInfo(conn.RawFd()).w_ready_ = false;
+            }
             buf += ret;
             sz -= ret;
             continue;
@@ -155,15 +279,506 @@ int Conn::WriteAll(const char *buf, ssize_t sz, int64_t timeout_ms) const
     return InternalWriteAll(*this, buf, sz, expire_at);
 }
 
+ssize_t Conn::WriteV(const struct iovec *iov, int iov_cnt, int64_t timeout_ms) const
+{
+    if (iov == nullptr || iov_cnt <= 0 || iov_cnt > IOV_MAX)
+    {
+        SetError("invalid iov count");
+        return err_code::kInvalid;
+    }
+
+    LOM_FIBER_CONN_INIT_EXPIRE_AT();
+    return InternalWriteV(*this, iov, iov_cnt, expire_at);
+}
+
+ssize_t Conn::ReadToChainBuf(io::ChainBuf &cb, int64_t timeout_ms) const
+{
+    return cb.ReadFrom(
+        [this, timeout_ms] (char *buf, ssize_t sz) -> ssize_t {
+            return Read(buf, sz, timeout_ms);
+        });
+}
+
+int Conn::WriteAllFromChainBuf(io::ChainBuf &cb, int64_t timeout_ms) const
+{
+    return cb.WriteAllTo(
+        [this, timeout_ms] (const struct iovec *iov, int iov_cnt) -> ssize_t {
+            return WriteV(iov, iov_cnt, timeout_ms);
+        });
+}
+
+namespace stackless
+{
+
+/*
+无栈任务中读写出错的处理，和LOM_FIBER_CONN_ON_IO_SYS_CALL_ERR的区别在于需要等待时不阻塞，
+而是设置would_block返回，由调用者登记等待
+*/
+#define LOM_FIBER_CONN_STACKLESS_ON_IO_SYS_CALL_ERR(_r_or_w) do {   \
+    Assert(ret == -1 && errno != 0);                                \
+    if (errno == ECONNRESET) {                                      \
+        SetError("connection reset by peer");                       \
+        return err_code::kConnReset;                                \
+    }                                                               \
+    if (errno == EWOULDBLOCK) {                                     \
+        errno = EAGAIN;                                             \
+    }                                                               \
+    if (errno == EINTR) {                                           \
+        continue;                                                   \
+    }                                                               \
+    if (errno != EAGAIN) {                                          \
+        SetError("syscall error");                                  \
+        return err_code::kSysCallFailed;                            \
+    }                                                               \
+    LOM_SDT_PROBE1(conn_eagain_##_r_or_w, conn.RawFd());            \
+    GetFdInfo(conn.RawFd())._r_or_w##_ready_ = false;               \
+    LOM_FIBER_CONN_STATS_ADD(_r_or_w##_wait_count_, 1);             \
+    would_block = true;                                             \
+    return 0;                                                       \
+} while (false)
+
+ssize_t TryRead(Conn conn, char *buf, ssize_t sz, bool &would_block)
+{
+    would_block = false;
+
+    if (sz <= 0 || !conn.Valid())
+    {
+        SetError("invalid conn or size");
+        return err_code::kInvalid;
+    }
+
+    for (;;)
+    {
+        ssize_t ret = LOM_FIBER_CONN_DO_IO_SYS_CALL(r, read(conn.RawFd(), buf, (size_t)sz));
+        if (ret >= 0)
+        {
+            LOM_SDT_PROBE3(conn_read, conn.RawFd(), sz, ret);
+            LOM_FIBER_CONN_STATS_ADD(r_bytes_, ret);
+            if (ret > 0 && ret < sz)
+            {
+                OnShortRead(conn.RawFd());
+            }
+            return ret;
+        }
+        LOM_FIBER_CONN_STACKLESS_ON_IO_SYS_CALL_ERR(r);
+    }
+}
+
+ssize_t TryWrite(Conn conn, const char *buf, ssize_t sz, bool &would_block)
+{
+    would_block = false;
+
+    if (sz < 0 || !conn.Valid())
+    {
+        SetError("invalid conn or size");
+        return err_code::kInvalid;
+    }
+
+    while (sz > 0)
+    {
+        ssize_t ret = LOM_FIBER_CONN_DO_IO_SYS_CALL(w, write(conn.RawFd(), buf, (size_t)sz));
+        if (ret > 0)
+        {
+            LOM_SDT_PROBE3(conn_write, conn.RawFd(), sz, ret);
+            LOM_FIBER_CONN_STATS_ADD(w_bytes_, ret);
+            if (ret < sz)
+            {
+                GetFdInfo(conn.RawFd()).w_ready_ = false;
+            }
+            return ret;
+        }
+        if (ret == 0)
+        {
+            continue;
+        }
+        LOM_FIBER_CONN_STACKLESS_ON_IO_SYS_CALL_ERR(w);
+    }
+
+    return 0;
+}
+
+#undef LOM_FIBER_CONN_STACKLESS_ON_IO_SYS_CALL_ERR
+
+}
+
+ssize_t Conn::SendFds(const char *buf, ssize_t sz, const int *fds, ssize_t fd_count, int64_t timeout_ms) const
+{
+    if (sz <= 0 || fd_count <= 0 || fd_count > kFdCountMaxPerMsg)
+    {
+        SetError("invalid data size or fd count");
+        return err_code::kInvalid;
+    }
+
+    if (!Valid())
+    {
+        SetError("invalid conn");
+        return err_code::kInvalid;
+    }
+
+    LOM_FIBER_CONN_INIT_EXPIRE_AT();
+    Conn conn = *this;
+
+    struct iovec iov;
+    iov.iov_base = const_cast<char *>(buf);
+    iov.iov_len = static_cast<size_t>(sz);
+
+    size_t fds_len = sizeof(int) * static_cast<size_t>(fd_count);
+    char ctrl_buf[CMSG_SPACE(sizeof(int) * kFdCountMaxPerMsg)];
+    memset(ctrl_buf, 0, sizeof(ctrl_buf));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl_buf;
+    msg.msg_controllen = CMSG_SPACE(fds_len);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(fds_len);
+    memcpy(CMSG_DATA(cmsg), fds, fds_len);
+
+    for (;;)
+    {
+        ssize_t ret = LOM_FIBER_CONN_DO_IO_SYS_CALL(w, sendmsg(conn.RawFd(), &msg, MSG_NOSIGNAL));
+        if (ret > 0)
+        {
+            LOM_FIBER_CONN_STATS_ADD(w_bytes_, ret);
+            if (ret < sz)
+            {
+                GetFdInfo(conn.RawFd()).w_ready_ = false;
+            }
+            return ret;
+        }
+        if (ret == 0)
+        {
+            if (expire_at >= 0 && expire_at <= NowMS())
+            {
+                SetError("timeout");
+                return err_code::kTimeout;
+            }
+            continue;
+        }
+        LOM_FIBER_CONN_ON_IO_SYS_CALL_ERR(w);
+    }
+}
+
+ssize_t Conn::RecvFds(char *buf, ssize_t sz, int *fds, ssize_t &fd_count, int64_t timeout_ms) const
+{
+    if (sz <= 0 || fd_count < 0)
+    {
+        SetError("invalid data size or fd count");
+        return err_code::kInvalid;
+    }
+
+    if (!Valid())
+    {
+        SetError("invalid conn");
+        return err_code::kInvalid;
+    }
+
+    LOM_FIBER_CONN_INIT_EXPIRE_AT();
+    Conn conn = *this;
+
+    for (;;)
+    {
+        struct iovec iov;
+        iov.iov_base = buf;
+        iov.iov_len = static_cast<size_t>(sz);
+
+        char ctrl_buf[CMSG_SPACE(sizeof(int) * kFdCountMaxPerMsg)];
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl_buf;
+        msg.msg_controllen = sizeof(ctrl_buf);
+
+        ssize_t ret = LOM_FIBER_CONN_DO_IO_SYS_CALL(r, recvmsg(conn.RawFd(), &msg, MSG_CMSG_CLOEXEC));
+        if (ret >= 0)
+        {
+            LOM_FIBER_CONN_STATS_ADD(r_bytes_, ret);
+            //收集所有附带的fd，超过调用者容量的部分直接关闭
+            ssize_t got_count = 0;
+            bool overflow = (msg.msg_flags & MSG_CTRUNC) != 0;
+            for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                {
+                    continue;
+                }
+                ssize_t count = static_cast<ssize_t>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+                for (ssize_t i = 0; i < count; ++ i)
+                {
+                    int fd;
+                    memcpy(&fd, CMSG_DATA(cmsg) + sizeof(int) * i, sizeof(int));
+                    if (got_count < fd_count)
+                    {
+                        fds[got_count] = fd;
+                        ++ got_count;
+                    }
+                    else
+                    {
+                        SilentClose(fd);
+                        overflow = true;
+                    }
+                }
+            }
+            if (overflow)
+            {
+                for (ssize_t i = 0; i < got_count; ++ i)
+                {
+                    SilentClose(fds[i]);
+                }
+                fd_count = 0;
+                SetError("too many fds received");
+                return err_code::kOverflow;
+            }
+            fd_count = got_count;
+
+            /*
+            不根据读取长度清除可读状态：Unix流式socket的recvmsg在附带fd的消息边界处会提前返回，
+            没读满不代表接收缓冲已被读空，后续排队的消息只能由下一次调用或EAGAIN确定
+            */
+            return ret;
+        }
+        LOM_FIBER_CONN_ON_IO_SYS_CALL_ERR(r);
+    }
+}
+
+//迁移连接时随fd发送的一个字节的数据
+static const char kSendConnTag = 'C';
+
+int Conn::SendConn(Conn conn, int64_t timeout_ms) const
+{
+    if (!conn.Valid())
+    {
+        SetError("invalid conn to send");
+        return err_code::kInvalid;
+    }
+
+    int fd = conn.RawFd();
+    ssize_t ret = SendFds(&kSendConnTag, 1, &fd, 1, timeout_ms);
+    if (ret < 0)
+    {
+        return static_cast<int>(ret);
+    }
+    Assert(ret == 1);
+
+    if (!conn.Close())
+    {
+        return err_code::kSysCallFailed;
+    }
+    return 0;
+}
+
+Conn Conn::RecvConn(int64_t timeout_ms, int *err_code) const
+{
+
+#define LOM_FIBER_CONN_ERR_RETURN(_err_code) do {   \
+    if (err_code != nullptr) {                      \
+        *err_code = (_err_code);                    \
+    }                                               \
+    return Conn();                                  \
+} while (false)
+
+    char tag;
+    int fd;
+    ssize_t fd_count = 1;
+    ssize_t ret = RecvFds(&tag, 1, &fd, fd_count, timeout_ms);
+    if (ret < 0)
+    {
+        LOM_FIBER_CONN_ERR_RETURN(static_cast<int>(ret));
+    }
+    if (ret == 0)
+    {
+        SetError("conn closed by peer");
+        LOM_FIBER_CONN_ERR_RETURN(err_code::kClosed);
+    }
+    if (tag != kSendConnTag || fd_count != 1)
+    {
+        if (fd_count > 0)
+        {
+            SilentClose(fd);
+        }
+        SetError("invalid conn handoff message");
+        LOM_FIBER_CONN_ERR_RETURN(err_code::kInvalid);
+    }
+
+    Conn conn = Conn::FromRawFd(fd);
+    if (!conn.Valid())
+    {
+        SilentClose(fd);
+        LOM_FIBER_CONN_ERR_RETURN(err_code::kSysCallFailed);
+    }
+
+#undef LOM_FIBER_CONN_ERR_RETURN
+
+    if (err_code != nullptr)
+    {
+        *err_code = 0;
+    }
+    return conn;
+}
+
+bool SetRawSockOpts(int fd, const ConnSockOpts &opts)
+{
+
+#define LOM_FIBER_CONN_SET_SOCK_OPT(_field, _level, _opt_name) do {                         \
+    if (opts._field >= 0) {                                                                 \
+        int v = opts._field;                                                                \
+        if (setsockopt(fd, (_level), (_opt_name), &v, sizeof(v)) == -1) {                   \
+            SetError("set socket option `" #_opt_name "` failed");                          \
+            return false;                                                                   \
+        }                                                                                   \
+    }                                                                                       \
+} while (false)
+
+    LOM_FIBER_CONN_SET_SOCK_OPT(no_delay_,          IPPROTO_TCP,    TCP_NODELAY);
+    LOM_FIBER_CONN_SET_SOCK_OPT(snd_buf_,           SOL_SOCKET,     SO_SNDBUF);
+    LOM_FIBER_CONN_SET_SOCK_OPT(rcv_buf_,           SOL_SOCKET,     SO_RCVBUF);
+    LOM_FIBER_CONN_SET_SOCK_OPT(not_sent_low_at_,   IPPROTO_TCP,    TCP_NOTSENT_LOWAT);
+    LOM_FIBER_CONN_SET_SOCK_OPT(quick_ack_,         IPPROTO_TCP,    TCP_QUICKACK);
+    LOM_FIBER_CONN_SET_SOCK_OPT(keep_alive_,        SOL_SOCKET,     SO_KEEPALIVE);
+    LOM_FIBER_CONN_SET_SOCK_OPT(keep_idle_sec_,     IPPROTO_TCP,    TCP_KEEPIDLE);
+    LOM_FIBER_CONN_SET_SOCK_OPT(keep_intvl_sec_,    IPPROTO_TCP,    TCP_KEEPINTVL);
+    LOM_FIBER_CONN_SET_SOCK_OPT(keep_cnt_,          IPPROTO_TCP,    TCP_KEEPCNT);
+
+#undef LOM_FIBER_CONN_SET_SOCK_OPT
+
+    return true;
+}
+
+bool Conn::SetSockOpts(const ConnSockOpts &opts) const
+{
+    if (!Valid())
+    {
+        SetError("invalid conn");
+        return false;
+    }
+    return SetRawSockOpts(RawFd(), opts);
+}
+
+bool Conn::SetCork(bool enable) const
+{
+    if (!Valid())
+    {
+        SetError("invalid conn");
+        return false;
+    }
+    int v = enable ? 1 : 0;
+    if (setsockopt(RawFd(), IPPROTO_TCP, TCP_CORK, &v, sizeof(v)) == -1)
+    {
+        SetError("set socket option `TCP_CORK` failed");
+        return false;
+    }
+    return true;
+}
+
+io::BufReader::Ptr Conn::NewBufReader(ssize_t buf_sz, int64_t timeout_ms) const
+{
+    Conn conn = *this;
+    return io::BufReader::New(
+        [conn, timeout_ms] (char *buf, ssize_t sz) -> ssize_t {
+            return conn.Read(buf, sz, timeout_ms);
+        },
+        buf_sz);
+}
+
+/*
+支持自动TCP_CORK的BufWriter，在内部BufWriter的基础上做一层封装：
+WriteAll过程中因缓冲满而发生写操作时，说明本次Flush前的数据需要多次写出，此时开启TCP_CORK，Flush结束时关闭
+*/
+class ConnBufWriter : public io::BufWriter
+{
+    Conn conn_;
+    int64_t timeout_ms_;
+    bool auto_cork_;
+    bool in_write_all_ = false;
+    bool corked_ = false;
+    //SetCork失败过（如Unix域socket不支持TCP_CORK），之后不再尝试，避免每次缓冲写满都做一次失败的系统调用
+    bool cork_unsupported_ = false;
+    io::BufWriter::Ptr bw_;
+
+    void MaybeCork()
+    {
+        if (auto_cork_ && in_write_all_ && !corked_ && !cork_unsupported_)
+        {
+            //失败了也不影响正确性，只是不能合并数据包，忽略错误
+            ErrProtector ep;
+            corked_ = conn_.SetCork(true);
+            cork_unsupported_ = !corked_;
+        }
+    }
+
+    ssize_t DoWrite(const char *buf, ssize_t sz)
+    {
+        MaybeCork();
+        return conn_.Write(buf, sz, timeout_ms_);
+    }
+
+    ssize_t DoWriteV(const struct iovec *iov, int iov_cnt)
+    {
+        MaybeCork();
+        return conn_.WriteV(iov, iov_cnt, timeout_ms_);
+    }
+
+public:
+
+    ConnBufWriter(Conn conn, ssize_t buf_sz, int64_t timeout_ms, bool auto_cork) :
+        conn_(conn), timeout_ms_(timeout_ms), auto_cork_(auto_cork)
+    {
+        bw_ = io::BufWriter::New(
+            [this] (const char *buf, ssize_t sz) -> ssize_t {
+                return DoWrite(buf, sz);
+            },
+            buf_sz,
+            [this] (const struct iovec *iov, int iov_cnt) -> ssize_t {
+                return DoWriteV(iov, iov_cnt);
+            });
+    }
+
+    virtual int WriteAll(const char *buf, ssize_t sz) override
+    {
+        in_write_all_ = true;
+        int ret = bw_->WriteAll(buf, sz);
+        in_write_all_ = false;
+        return ret;
+    }
+
+    virtual int Flush() override
+    {
+        int ret = bw_->Flush();
+        if (corked_)
+        {
+            ErrProtector ep;
+            conn_.SetCork(false);
+            corked_ = false;
+        }
+        return ret;
+    }
+};
+
+io::BufWriter::Ptr Conn::NewBufWriter(ssize_t buf_sz, int64_t timeout_ms, bool auto_cork) const
+{
+    return io::BufWriter::Ptr(new ConnBufWriter(*this, buf_sz, timeout_ms, auto_cork));
+}
+
 Conn Conn::FromRawFd(int fd)
 {
     Conn conn;
-    conn.Reg(fd);
+    if (conn.Reg(fd) && IsConnStatsEnabledByDefault())
+    {
+        conn.EnableStats();
+    }
     return conn;
 }
 
 static Conn ConnectStreamSock(
-    int socket_family, struct sockaddr *addr, socklen_t addr_len, int64_t timeout_ms, int *err_code)
+    int socket_family, struct sockaddr *addr, socklen_t addr_len, int64_t timeout_ms, int *err_code,
+    const ConnSockOpts *opts = nullptr)
 {
     LOM_FIBER_CONN_INIT_EXPIRE_AT();
 
@@ -188,6 +803,11 @@ static Conn ConnectStreamSock(
         LOM_FIBER_CONN_ERR_RETURN("set connection socket nonblocking failed", kSysCallFailed);
     }
 
+    if (opts != nullptr && !SetRawSockOpts(conn_sock, *opts))
+    {
+        LOM_FIBER_CONN_ERR_RETURN("set connection socket options failed", kSysCallFailed);
+    }
+
     int ret = connect(conn_sock, addr, addr_len);
     if (ret == -1 && errno != EINPROGRESS)
     {
@@ -250,16 +870,19 @@ static Conn ConnectStreamSock(
         LOM_FIBER_CONN_ERR_RETURN("connect failed", kSysCallFailed);
     }
 
-    //set tcp nodelay as possible
-    int enable = 1;
-    setsockopt(conn_sock, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    if (opts == nullptr || opts->no_delay_ < 0)
+    {
+        //set tcp nodelay as possible
+        int enable = 1;
+        setsockopt(conn_sock, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
 
 #undef LOM_FIBER_CONN_ERR_RETURN
 
     return conn;
 }
 
-Conn ConnectTCP(const char *ip, uint16_t port, int64_t timeout_ms, int *err_code)
+Conn ConnectTCP(const char *ip, uint16_t port, int64_t timeout_ms, int *err_code, const ConnSockOpts *opts)
 {
     struct sockaddr_in addr;
     memset(&addr, 0, sizeof(addr));
@@ -283,7 +906,7 @@ Conn ConnectTCP(const char *ip, uint16_t port, int64_t timeout_ms, int *err_code
     addr.sin_port = htons(port);
 
     return ConnectStreamSock(
-        AF_INET, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr), timeout_ms, err_code);
+        AF_INET, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr), timeout_ms, err_code, opts);
 }
 
 Conn ConnectUnixSockStream(const char *path, int64_t timeout_ms, int *err_code)
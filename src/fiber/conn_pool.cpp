@@ -0,0 +1,263 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+无阻塞地检查空闲连接是否还能复用：
+    对端关闭时recv返回0，有数据可读说明协议状态已经不确定了，这两种情况都不能复用，
+    只有返回EAGAIN才表示连接正常空闲
+*/
+static bool IsIdleConnHealthy(Conn conn)
+{
+    if (!conn.Valid())
+    {
+        return false;
+    }
+
+    int save_errno = errno;
+    char c;
+    ssize_t ret = recv(conn.RawFd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    bool healthy = ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    errno = save_errno;
+    return healthy;
+}
+
+class ConnPoolImpl : public ConnPool
+{
+    struct IdleConn
+    {
+        Conn conn_;
+        int64_t idle_at_;
+    };
+
+    struct KeyInfo
+    {
+        //按归还时间排列，复用时从尾部取最近归还的，清理时从头部取最早归还的
+        std::list<IdleConn> idle_conns_;
+        ssize_t conn_count_ = 0;
+
+        //借出中的连接，用于识别归还的连接是否属于这个key
+        std::set<Conn> borrowed_conns_;
+
+        /*
+        仅在限制了连接数时使用，值表示剩余可借出的额度，每次Get占用一个额度，归还时释放
+        由于只在没有空闲连接时才新建连接，所以借出数不超过上限就保证了总连接数不超过上限
+        */
+        Sem sem_;
+    };
+
+    DialFunc dial_;
+    ConnPoolOptions opts_;
+    std::map<Str, KeyInfo> key_infos_;
+
+    KeyInfo &GetKeyInfo(const Str &key)
+    {
+        auto iter = key_infos_.find(key);
+        if (iter == key_infos_.end())
+        {
+            iter = key_infos_.emplace(key, KeyInfo()).first;
+            if (opts_.conn_count_max_per_key_ > 0)
+            {
+                iter->second.sem_ = Sem::New(static_cast<uint64_t>(opts_.conn_count_max_per_key_));
+            }
+        }
+        return iter->second;
+    }
+
+    static void CloseConn(KeyInfo &key_info, Conn conn)
+    {
+        if (conn.Valid())
+        {
+            ErrProtector ep;
+            conn.Close();
+        }
+        Assert(key_info.conn_count_ > 0);
+        -- key_info.conn_count_;
+    }
+
+    static void ReleaseQuota(KeyInfo &key_info)
+    {
+        if (key_info.sem_.Valid())
+        {
+            ErrProtector ep;
+            key_info.sem_.Release(1);
+        }
+    }
+
+public:
+
+    ConnPoolImpl(DialFunc dial, const ConnPoolOptions &opts) : dial_(dial), opts_(opts)
+    {
+    }
+
+    virtual ~ConnPoolImpl()
+    {
+        ErrProtector ep;
+        for (auto &kv : key_infos_)
+        {
+            KeyInfo &key_info = kv.second;
+            for (auto const &idle_conn : key_info.idle_conns_)
+            {
+                idle_conn.conn_.Close();
+            }
+            if (key_info.sem_.Valid())
+            {
+                key_info.sem_.Destroy();
+            }
+        }
+    }
+
+    virtual Conn Get(const Str &key, int64_t timeout_ms, int *err_code) override
+    {
+
+#define LOM_FIBER_CONN_POOL_ERR_RETURN(_err_code) do {  \
+    if (err_code != nullptr) {                          \
+        *err_code = (_err_code);                        \
+    }                                                   \
+    return Conn();                                      \
+} while (false)
+
+        int64_t expire_at = timeout_ms < 0 ? -1 : NowMS() + timeout_ms;
+
+        KeyInfo &key_info = GetKeyInfo(key);
+
+        if (key_info.sem_.Valid())
+        {
+            int ret = key_info.sem_.Acquire(1, timeout_ms);
+            if (ret != 0)
+            {
+                LOM_FIBER_CONN_POOL_ERR_RETURN(ret);
+            }
+        }
+
+        while (!key_info.idle_conns_.empty())
+        {
+            Conn conn = key_info.idle_conns_.back().conn_;
+            key_info.idle_conns_.pop_back();
+            if (IsIdleConnHealthy(conn))
+            {
+                key_info.borrowed_conns_.insert(conn);
+                if (err_code != nullptr)
+                {
+                    *err_code = 0;
+                }
+                return conn;
+            }
+            CloseConn(key_info, conn);
+        }
+
+        int64_t remain_ms = -1;
+        if (expire_at >= 0)
+        {
+            remain_ms = expire_at - NowMS();
+            if (remain_ms <= 0)
+            {
+                ReleaseQuota(key_info);
+                SetError("timeout");
+                LOM_FIBER_CONN_POOL_ERR_RETURN(err_code::kTimeout);
+            }
+        }
+
+        Conn conn = dial_(key, remain_ms, err_code);
+        if (!conn.Valid())
+        {
+            ReleaseQuota(key_info);
+            return conn;
+        }
+
+        ++ key_info.conn_count_;
+        key_info.borrowed_conns_.insert(conn);
+        return conn;
+
+#undef LOM_FIBER_CONN_POOL_ERR_RETURN
+
+    }
+
+    virtual int Put(const Str &key, Conn conn, bool reusable) override
+    {
+        auto iter = key_infos_.find(key);
+        if (iter == key_infos_.end() || iter->second.borrowed_conns_.erase(conn) == 0)
+        {
+            SetError("conn not borrowed by this key");
+            return err_code::kInvalid;
+        }
+        KeyInfo &key_info = iter->second;
+
+        if (!reusable || !conn.Valid() ||
+            static_cast<ssize_t>(key_info.idle_conns_.size()) >= opts_.idle_count_max_per_key_)
+        {
+            CloseConn(key_info, conn);
+        }
+        else
+        {
+            key_info.idle_conns_.emplace_back(IdleConn{conn, NowMS()});
+        }
+
+        ReleaseQuota(key_info);
+        return 0;
+    }
+
+    virtual ssize_t IdleCount(const Str &key) const override
+    {
+        auto iter = key_infos_.find(key);
+        return iter == key_infos_.end() ? 0 : static_cast<ssize_t>(iter->second.idle_conns_.size());
+    }
+
+    virtual ssize_t ConnCount(const Str &key) const override
+    {
+        auto iter = key_infos_.find(key);
+        return iter == key_infos_.end() ? 0 : iter->second.conn_count_;
+    }
+
+    void EvictIdleConns()
+    {
+        int64_t evict_before = NowMS() - opts_.idle_timeout_ms_;
+        for (auto &kv : key_infos_)
+        {
+            KeyInfo &key_info = kv.second;
+            while (!key_info.idle_conns_.empty() && key_info.idle_conns_.front().idle_at_ <= evict_before)
+            {
+                Conn conn = key_info.idle_conns_.front().conn_;
+                key_info.idle_conns_.pop_front();
+                CloseConn(key_info, conn);
+            }
+        }
+    }
+};
+
+ConnPool::Ptr ConnPool::New(DialFunc dial, const ConnPoolOptions &opts)
+{
+    AssertInited();
+
+    auto pool = std::make_shared<ConnPoolImpl>(dial, opts);
+
+    if (opts.idle_timeout_ms_ > 0)
+    {
+        //后台fiber定期清理超时的空闲连接，连接池被销毁后自行退出
+        std::weak_ptr<ConnPoolImpl> wp = pool;
+        int64_t interval_ms = std::max<int64_t>(opts.idle_timeout_ms_ / 4, 100);
+        Create(
+            [wp, interval_ms] () {
+                for (;;)
+                {
+                    SleepMS(interval_ms);
+                    auto p = wp.lock();
+                    if (!p)
+                    {
+                        return;
+                    }
+                    p->EvictIdleConns();
+                }
+            });
+    }
+
+    return pool;
+}
+
+}
+
+}
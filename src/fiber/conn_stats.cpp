@@ -0,0 +1,84 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+static thread_local bool conn_stats_enabled_by_default = false;
+
+//开启了统计的fd，用于遍历
+static thread_local std::set<int> conn_stats_fds;
+
+void SetConnStatsEnabledByDefault(bool enabled)
+{
+    conn_stats_enabled_by_default = enabled;
+}
+
+bool IsConnStatsEnabledByDefault()
+{
+    return conn_stats_enabled_by_default;
+}
+
+void FreeConnStats(int fd)
+{
+    FdInfo &fd_info = GetFdInfo(fd);
+    if (fd_info.stats_ != nullptr)
+    {
+        delete fd_info.stats_;
+        fd_info.stats_ = nullptr;
+        conn_stats_fds.erase(fd);
+    }
+}
+
+bool Conn::EnableStats() const
+{
+    if (!Valid())
+    {
+        SetError("invalid conn");
+        return false;
+    }
+
+    FdInfo &fd_info = GetFdInfo(RawFd());
+    if (fd_info.stats_ == nullptr)
+    {
+        fd_info.stats_ = new ConnStats;
+        fd_info.stats_->fd_ = RawFd();
+        fd_info.stats_->enabled_at_ms_ = NowMS();
+        conn_stats_fds.insert(RawFd());
+    }
+    return true;
+}
+
+bool Conn::GetStats(ConnStats &stats) const
+{
+    if (!Valid())
+    {
+        SetError("invalid conn");
+        return false;
+    }
+
+    const ConnStats *p = GetFdInfo(RawFd()).stats_;
+    if (p == nullptr)
+    {
+        SetError("stats of conn is not enabled");
+        return false;
+    }
+    stats = *p;
+    return true;
+}
+
+GoSlice<ConnStats> AllConnStats()
+{
+    GoSlice<ConnStats> all(0, static_cast<ssize_t>(conn_stats_fds.size()));
+    for (int fd : conn_stats_fds)
+    {
+        all = all.Append(*GetFdInfo(fd).stats_);
+    }
+    return all;
+}
+
+}
+
+}
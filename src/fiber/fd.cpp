@@ -8,25 +8,58 @@ namespace fiber
 
 static const int kFastFdSeqMapSizeMax = 10 * 10000;
 
-static thread_local uint32_t *fast_fd_seq_map = nullptr;
-static thread_local std::map<int, uint32_t> slow_fd_seq_map;
+static thread_local FdInfo *fast_fd_info_map = nullptr;
+static thread_local std::map<int, FdInfo> slow_fd_info_map;
+
+static thread_local int64_t skipped_io_sys_call_count = 0;
+
+FdInfo &GetFdInfo(int fd)
+{
+    return fd >= 0 && fd < kFastFdSeqMapSizeMax ? fast_fd_info_map[fd] : slow_fd_info_map[fd];
+}
 
 static uint32_t &FdSeq(int fd)
 {
-    return fd >= 0 && fd < kFastFdSeqMapSizeMax ? fast_fd_seq_map[fd] : slow_fd_seq_map[fd];
+    return GetFdInfo(fd).seq_;
 }
 
 bool InitFdEnv()
 {
-    fast_fd_seq_map = new uint32_t[kFastFdSeqMapSizeMax];
-    for (auto i = 0; i < kFastFdSeqMapSizeMax; ++ i)
+    fast_fd_info_map = new FdInfo[kFastFdSeqMapSizeMax];
+    return true;
+}
+
+void OnIOSysCallSkipped()
+{
+    ++ skipped_io_sys_call_count;
+}
+
+int64_t SkippedIOSysCallCount()
+{
+    return skipped_io_sys_call_count;
+}
+
+//判断fd是否为流式的（SOCK_STREAM的socket或管道），不改变errno
+static bool IsStreamFd(int fd)
+{
+    int save_errno = errno;
+    bool is_stream = false;
+    int type;
+    socklen_t type_len = sizeof(type);
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &type_len) == 0)
     {
-        fast_fd_seq_map[i] = 0;
+        is_stream = type == SOCK_STREAM;
     }
-    return true;
+    else
+    {
+        struct stat st;
+        is_stream = fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    }
+    errno = save_errno;
+    return is_stream;
 }
 
-bool Fd::Reg(int fd)
+bool Fd::Reg(int fd, bool epoll_exclusive)
 {
     AssertInited();
 
@@ -49,7 +82,7 @@ bool Fd::Reg(int fd)
         return false;
     }
 
-    if (!RegRawFdToSched(fd))
+    if (!RegRawFdToSched(fd, epoll_exclusive))
     {
         return false;
     }
@@ -57,6 +90,14 @@ bool Fd::Reg(int fd)
     fd_ = fd;
     seq_ = FdSeq(fd_);
 
+    //新注册的fd的可读写状态未知，视为就绪，由第一次系统调用确定
+    FreeConnStats(fd_);
+    FdInfo &fd_info = GetFdInfo(fd_);
+    fd_info.r_ready_ = true;
+    fd_info.w_ready_ = true;
+    fd_info.hup_ = false;
+    fd_info.stream_ = IsStreamFd(fd_);
+
     return true;
 }
 
@@ -72,6 +113,7 @@ bool Fd::Unreg() const
 
     bool ok = UnregRawFdFromSched(fd_);
     ++ FdSeq(fd_);
+    FreeConnStats(fd_);
     return ok;
 }
 
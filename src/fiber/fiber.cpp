@@ -12,26 +12,121 @@ static thread_local int64_t next_fiber_seq = 1;
 static thread_local Fiber *initing_fiber;
 static thread_local ucontext_t fiber_init_ret_uctx;
 
-Fiber::Fiber(std::function<void ()> run, ssize_t stk_sz) : run_(run), finished_(false), stk_sz_(stk_sz)
+//本线程存活fiber链表的头
+static thread_local Fiber *live_fibers = nullptr;
+
+/*
+fiber的汇编入口，作为makecontext的目标，再调用Fiber::Start
+fiber栈是申请的一块普通内存，通过longjmp切入，若直接以Fiber::Start为入口，则其栈底的帧指针和返回地址
+都是makecontext时残留的值，perf等工具按帧指针或DWARF回溯时会越过栈底回溯到无关的内存，
+因此在这里将帧指针清零并用CFI标记返回地址未定义，使得两种回溯方式都在fiber栈底正确结束
+*/
+extern "C" void lom_fiber_entry();
+
+extern "C" __attribute__((visibility("hidden"), used)) void lom_fiber_start()
 {
-    stk_ = new char[stk_sz_];
+    Fiber::Start();
+}
+
+#if defined(__x86_64__)
+
+//入口处rsp按16字节对齐后偏移8（相当于刚被call），需先调整对齐再调用
+__asm__ (
+    ".text\n"
+    ".p2align 4\n"
+    ".type lom_fiber_entry, @function\n"
+    "lom_fiber_entry:\n"
+    ".cfi_startproc\n"
+    ".cfi_undefined rip\n"
+    "xorl %ebp, %ebp\n"
+    "subq $8, %rsp\n"
+    ".cfi_adjust_cfa_offset 8\n"
+    "call lom_fiber_start\n"
+    "ud2\n"
+    ".cfi_endproc\n"
+    ".size lom_fiber_entry, .-lom_fiber_entry\n"
+);
+
+#elif defined(__aarch64__)
+
+__asm__ (
+    ".text\n"
+    ".p2align 2\n"
+    ".type lom_fiber_entry, %function\n"
+    "lom_fiber_entry:\n"
+    ".cfi_startproc\n"
+    ".cfi_undefined x30\n"
+    "mov x29, #0\n"
+    "mov x30, #0\n"
+    "bl lom_fiber_start\n"
+    "brk #0\n"
+    ".cfi_endproc\n"
+    ".size lom_fiber_entry, .-lom_fiber_entry\n"
+);
+
+#else
+
+extern "C" void lom_fiber_entry()
+{
+    Fiber::Start();
+}
+
+#endif
+
+void Fiber::LinkToLiveFibers()
+{
+    next_ = live_fibers;
+    if (next_ != nullptr)
+    {
+        next_->prev_ = this;
+    }
+    live_fibers = this;
 
     seq_ = next_fiber_seq;
     ++ next_fiber_seq;
+}
+
+Fiber::Fiber(std::function<void ()> run, ssize_t stk_sz, CodePos create_pos) :
+    run_(run), finished_(false), stk_sz_(stk_sz), create_pos_(create_pos)
+{
+    LinkToLiveFibers();
+
+    stk_ = new char[stk_sz_];
 
     ucontext_t uctx;
     Assert(getcontext(&uctx) == 0);
     uctx.uc_stack.ss_sp = stk_;
     uctx.uc_stack.ss_size = stk_sz_;
     uctx.uc_link = nullptr;
-    makecontext(&uctx, Fiber::Start, 0);
+    makecontext(&uctx, lom_fiber_entry, 0);
     initing_fiber = this;
     Assert(swapcontext(&fiber_init_ret_uctx, &uctx) == 0);
 }
 
+Fiber::Fiber(stackless::ResumeFunc resume, void *resume_arg, CodePos create_pos) :
+    resume_(resume), resume_arg_(resume_arg), finished_(false), stk_(nullptr), stk_sz_(0),
+    create_pos_(create_pos)
+{
+    LinkToLiveFibers();
+}
+
 Fiber::~Fiber()
 {
+    if (prev_ != nullptr)
+    {
+        prev_->next_ = next_;
+    }
+    else
+    {
+        live_fibers = next_;
+    }
+    if (next_ != nullptr)
+    {
+        next_->prev_ = prev_;
+    }
+
     delete[] stk_;
+    delete[] local_slots_;
 }
 
 void Fiber::Start()
@@ -48,6 +143,7 @@ void Fiber::Start()
     {
         Fiber *curr_fiber = GetCurrFiber();
         curr_fiber->run_();
+        curr_fiber->ClearLocalSlots();
         curr_fiber->finished_ = true;
 
         curr_fiber->run_ = [] () {};
@@ -61,17 +157,47 @@ void Fiber::Start()
     }
 }
 
-Fiber *Fiber::New(std::function<void ()> run, ssize_t stk_sz)
+Fiber *Fiber::New(std::function<void ()> run, ssize_t stk_sz, CodePos create_pos)
+{
+    return new Fiber(run, stk_sz, create_pos);
+}
+
+Fiber *Fiber::NewStackless(stackless::ResumeFunc resume, void *resume_arg, CodePos create_pos)
+{
+    return new Fiber(resume, resume_arg, create_pos);
+}
+
+void Fiber::FinishStackless()
+{
+    Assert(IsStackless());
+    ClearLocalSlots();
+    finished_ = true;
+    waiting_evs_.Reset();
+}
+
+Fiber *Fiber::LiveFibers()
+{
+    return live_fibers;
+}
+
+FiberStat Fiber::Stat() const
 {
-    return new Fiber(run, stk_sz);
+    FiberStat stat;
+    stat.seq_ = seq_;
+    stat.create_pos_ = create_pos_;
+    stat.run_ns_ = run_ns_;
+    stat.run_ns_max_ = run_ns_max_;
+    stat.switch_in_count_ = switch_in_count_;
+    return stat;
 }
 
 void Fiber::Destroy()
 {
+    LOM_SDT_PROBE1(fiber_destroy, seq_);
     delete this;
 }
 
-void Create(std::function<void ()> run, ssize_t stk_sz)
+void Create(std::function<void ()> run, ssize_t stk_sz, CodePos _cp)
 {
     AssertInited();
     if (stk_sz < kStkSizeMin)
@@ -82,7 +208,9 @@ void Create(std::function<void ()> run, ssize_t stk_sz)
     {
         stk_sz = kStkSizeMax;
     }
-    RegFiber(Fiber::New(run, stk_sz));
+    Fiber *fiber = Fiber::New(run, stk_sz, _cp);
+    LOM_SDT_PROBE2(fiber_create, fiber->Seq(), stk_sz);
+    RegFiber(fiber);
 }
 
 }
@@ -0,0 +1,95 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+key的注册表，在锁内写入destructor后再发布key数量，
+使用者只能拿到已发布的key，因此读取destructor不需要加锁
+FiberLocal一般定义为全局变量，会在其他编译单元的全局初始化阶段调用NewFiberLocalKey，
+因此这里的对象都必须是常量初始化的，不能依赖动态初始化的顺序
+*/
+static std::mutex fiber_local_key_lock;
+static std::atomic<ssize_t> fiber_local_key_count(0);
+static void (*fiber_local_destructors[kFiberLocalKeyCountMax])(void *);
+
+ssize_t NewFiberLocalKey(void (*destructor)(void *))
+{
+    std::lock_guard<std::mutex> lock(fiber_local_key_lock);
+    ssize_t key = fiber_local_key_count.load();
+    if (key >= kFiberLocalKeyCountMax)
+    {
+        SetError("fiber local keys are exhausted");
+        return -1;
+    }
+    fiber_local_destructors[key] = destructor;
+    fiber_local_key_count.store(key + 1);
+    return key;
+}
+
+void *GetFiberLocal(ssize_t key)
+{
+    Assert(key >= 0 && key < kFiberLocalKeyCountMax);
+    Fiber *fiber = GetCurrFiber();
+    return fiber == nullptr ? nullptr : fiber->LocalSlot(key);
+}
+
+bool SetFiberLocal(ssize_t key, void *v)
+{
+    Assert(key >= 0 && key < kFiberLocalKeyCountMax);
+    Fiber *fiber = GetCurrFiber();
+    if (fiber == nullptr)
+    {
+        SetError("not in fiber");
+        return false;
+    }
+    fiber->SetLocalSlot(key, v);
+    return true;
+}
+
+void Fiber::SetLocalSlot(ssize_t key, void *v)
+{
+    if (local_slots_ == nullptr)
+    {
+        local_slots_ = new void *[kFiberLocalKeyCountMax]();
+    }
+    local_slots_[key] = v;
+}
+
+void Fiber::ClearLocalSlots()
+{
+    if (local_slots_ == nullptr)
+    {
+        return;
+    }
+
+    /*
+    destructor中可能又设置了槽位（例如使用了其他FiberLocal），因此反复清理直到全部为空，
+    每个值先从槽位中取出再调用destructor，避免重复释放
+    */
+    ssize_t key_count = fiber_local_key_count.load();
+    for (bool found = true; found;)
+    {
+        found = false;
+        for (ssize_t key = 0; key < key_count; ++ key)
+        {
+            void *v = local_slots_[key];
+            if (v != nullptr)
+            {
+                local_slots_[key] = nullptr;
+                if (fiber_local_destructors[key] != nullptr)
+                {
+                    fiber_local_destructors[key](v);
+                }
+                found = true;
+            }
+        }
+    }
+}
+
+}
+
+}
@@ -0,0 +1,250 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+GoSlice<FiberStat> TopFibersByRunTime(ssize_t n)
+{
+    AssertInited();
+
+    std::vector<FiberStat> stats;
+    for (Fiber *fiber = Fiber::LiveFibers(); fiber != nullptr; fiber = fiber->Next())
+    {
+        stats.emplace_back(fiber->Stat());
+    }
+
+    n = std::max<ssize_t>(std::min<ssize_t>(n, static_cast<ssize_t>(stats.size())), 0);
+    std::partial_sort(
+        stats.begin(), stats.begin() + n, stats.end(),
+        [] (const FiberStat &a, const FiberStat &b) {
+            return a.run_ns_ > b.run_ns_;
+        });
+
+    GoSlice<FiberStat> top(0, n);
+    for (ssize_t i = 0; i < n; ++ i)
+    {
+        top = top.Append(stats.at(static_cast<size_t>(i)));
+    }
+    return top;
+}
+
+/*
+每个调度线程的运行状态，由调度线程写，看门狗线程读
+switch_in_at_为当前fiber的切入时间，0表示当前在调度器中
+对象注册后不会销毁，线程结束Run时只标记为不再存活
+*/
+struct SchedWatchState
+{
+    pthread_t tid_;
+    std::atomic<bool> alive_{true};
+    std::atomic<int64_t> switch_in_at_{0};
+
+    //以下只由看门狗线程访问
+    int64_t reported_switch_in_at_ = 0;
+};
+
+static std::mutex &sched_watch_lock = *new std::mutex;
+static std::vector<SchedWatchState *> &sched_watch_states = *new std::vector<SchedWatchState *>;
+static bool watchdog_started = false;
+
+static thread_local SchedWatchState *curr_sched_watch_state = nullptr;
+static thread_local const Fiber *running_fiber = nullptr;
+
+void OnSchedRunBegin()
+{
+    if (curr_sched_watch_state == nullptr)
+    {
+        curr_sched_watch_state = new SchedWatchState;
+        curr_sched_watch_state->tid_ = pthread_self();
+        std::lock_guard<std::mutex> lock(sched_watch_lock);
+        sched_watch_states.emplace_back(curr_sched_watch_state);
+    }
+    curr_sched_watch_state->alive_.store(true);
+}
+
+void OnSchedRunEnd()
+{
+    curr_sched_watch_state->alive_.store(false);
+}
+
+int64_t OnFiberSwitchIn(Fiber *fiber)
+{
+    LOM_FIBER_SCHED_TRACE(kSchedTraceSwitchIn, fiber->Seq());
+    LOM_SDT_PROBE1(fiber_switch_in, fiber->Seq());
+    int64_t now = NowClockNS();
+    running_fiber = fiber;
+    OnPreemptSliceBegin(now);
+    curr_sched_watch_state->switch_in_at_.store(now, std::memory_order_relaxed);
+    return now;
+}
+
+void OnFiberSwitchOut(Fiber *fiber, int64_t switch_in_at)
+{
+    curr_sched_watch_state->switch_in_at_.store(0, std::memory_order_relaxed);
+    running_fiber = nullptr;
+    int64_t run_ns = NowClockNS() - switch_in_at;
+    fiber->OnSwitchedOut(run_ns);
+    LOM_SDT_PROBE2(fiber_switch_out, fiber->Seq(), run_ns);
+    LOM_FIBER_SCHED_TRACE(kSchedTraceSwitchOut, fiber->Seq(), fiber->IsFinished() ? 1 : 0);
+}
+
+//信号处理函数中只能使用异步信号安全的操作，因此手工格式化到栈上的缓冲
+class SigSafeWriter
+{
+    char buf_[1024];
+    size_t len_ = 0;
+
+public:
+
+    void Append(const char *s)
+    {
+        while (*s != '\0' && len_ < sizeof(buf_))
+        {
+            buf_[len_] = *s;
+            ++ len_;
+            ++ s;
+        }
+    }
+
+    void Append(int64_t v)
+    {
+        char tmp[24];
+        size_t i = sizeof(tmp);
+        tmp[-- i] = '\0';
+        bool neg = v < 0;
+        uint64_t u = neg ? -static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+        do
+        {
+            tmp[-- i] = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u > 0);
+        if (neg)
+        {
+            tmp[-- i] = '-';
+        }
+        Append(tmp + i);
+    }
+
+    void Flush()
+    {
+        size_t pos = 0;
+        while (pos < len_)
+        {
+            ssize_t ret = write(STDERR_FILENO, buf_ + pos, len_ - pos);
+            if (ret <= 0)
+            {
+                if (ret == -1 && errno == EINTR)
+                {
+                    continue;
+                }
+                break;
+            }
+            pos += static_cast<size_t>(ret);
+        }
+        len_ = 0;
+    }
+};
+
+static void WatchdogSigHandler(int)
+{
+    int save_errno = errno;
+
+    const Fiber *fiber = running_fiber;
+    SchedWatchState *state = curr_sched_watch_state;
+    int64_t switch_in_at = state == nullptr ? 0 : state->switch_in_at_.load(std::memory_order_relaxed);
+    if (fiber == nullptr || switch_in_at == 0)
+    {
+        //信号到达前fiber已经切出了
+        errno = save_errno;
+        return;
+    }
+
+    SigSafeWriter w;
+    w.Append("lom::fiber watchdog: fiber [");
+    w.Append(fiber->Seq());
+    w.Append("] created at File [");
+    w.Append(fiber->CreatePos().FileName());
+    w.Append("] Line [");
+    w.Append(static_cast<int64_t>(fiber->CreatePos().LineNum()));
+    w.Append("] Func [");
+    w.Append(fiber->CreatePos().FuncName());
+    w.Append("] has been running for [");
+    w.Append((NowClockNS() - switch_in_at) / 1000000);
+    w.Append("] ms without yielding, backtrace:\n");
+    w.Flush();
+
+    void *frames[64];
+    int frame_count = backtrace(frames, 64);
+    backtrace_symbols_fd(frames, frame_count, STDERR_FILENO);
+
+    errno = save_errno;
+}
+
+static void Watchdog(int64_t threshold_ms, int sig)
+{
+    int64_t threshold_ns = threshold_ms * 1000000;
+    auto interval = std::chrono::milliseconds(std::max<int64_t>(threshold_ms / 4, 1));
+    for (;;)
+    {
+        std::this_thread::sleep_for(interval);
+
+        int64_t now = NowClockNS();
+        std::lock_guard<std::mutex> lock(sched_watch_lock);
+        for (SchedWatchState *state : sched_watch_states)
+        {
+            if (!state->alive_.load())
+            {
+                continue;
+            }
+            int64_t switch_in_at = state->switch_in_at_.load(std::memory_order_relaxed);
+            if (switch_in_at != 0 && now - switch_in_at >= threshold_ns &&
+                switch_in_at != state->reported_switch_in_at_)
+            {
+                state->reported_switch_in_at_ = switch_in_at;
+                pthread_kill(state->tid_, sig);
+            }
+        }
+    }
+}
+
+bool StartFiberWatchdog(int64_t threshold_ms, int sig)
+{
+    if (threshold_ms <= 0)
+    {
+        SetError("invalid watchdog threshold");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(sched_watch_lock);
+    if (watchdog_started)
+    {
+        SetError("fiber watchdog is already started");
+        return false;
+    }
+
+    //提前调用一次backtrace，使其依赖的库在正常上下文中完成加载，之后在信号处理函数中调用时不会申请内存
+    void *frames[1];
+    backtrace(frames, 1);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = WatchdogSigHandler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(sig, &sa, nullptr) == -1)
+    {
+        SetError("install watchdog signal handler failed");
+        return false;
+    }
+
+    std::thread(Watchdog, threshold_ms, sig).detach();
+    watchdog_started = true;
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,521 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+static thread_local bool file_io_uring_disabled = false;
+
+/*
+每个调度线程一个io_uring实例，提交请求后当前fiber在请求的sem上等待，
+io_uring通过注册的eventfd通知完成事件，由服务fiber读取eventfd后收割完成队列并唤醒对应的fiber
+*/
+class IOUring
+{
+    int ring_fd_ = -1;
+
+    unsigned *sq_head_, *sq_tail_, *sq_mask_, *sq_array_;
+    struct io_uring_sqe *sqes_;
+
+    unsigned *cq_head_, *cq_tail_, *cq_mask_;
+    struct io_uring_cqe *cqes_;
+
+    //限制同时进行的请求数不超过完成队列的大小，避免完成队列溢出
+    Sem inflight_sem_;
+
+    int event_fd_ = -1;
+
+    void Reap()
+    {
+        unsigned head = *cq_head_;
+        while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+        {
+            struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+            Req *req = reinterpret_cast<Req *>(cqe->user_data);
+            req->res_ = cqe->res;
+            req->sem_.Release(1);
+            ++ head;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    void Serve()
+    {
+        Conn ev_conn = Conn::FromRawFd(event_fd_);
+        if (!ev_conn.Valid())
+        {
+            Die(Str("lom::fiber: register io_uring eventfd failed: ").Concat(Err()));
+        }
+
+        for (;;)
+        {
+            uint64_t count;
+            ssize_t ret = ev_conn.Read(reinterpret_cast<char *>(&count), sizeof(count));
+            if (ret != sizeof(count))
+            {
+                Die(Str("lom::fiber: read io_uring eventfd failed: ").Concat(Err()));
+            }
+            Reap();
+        }
+    }
+
+    static bool IsOpSupported(const struct io_uring_probe *probe, uint8_t op)
+    {
+        return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    //探测需要的操作是否都被内核支持
+    bool Probe()
+    {
+        static const int kProbeOpCount = 256;
+        size_t probe_sz = sizeof(struct io_uring_probe) + kProbeOpCount * sizeof(struct io_uring_probe_op);
+        auto probe = reinterpret_cast<struct io_uring_probe *>(calloc(1, probe_sz));
+        Assert(probe != nullptr);
+        Defer defer_free_probe(
+            [probe] () {
+                free(probe);
+            });
+
+        if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE, probe, kProbeOpCount) < 0)
+        {
+            return false;
+        }
+        return
+            IsOpSupported(probe, IORING_OP_READ) && IsOpSupported(probe, IORING_OP_WRITE) &&
+            IsOpSupported(probe, IORING_OP_FSYNC) && IsOpSupported(probe, IORING_OP_FALLOCATE);
+    }
+
+public:
+
+    struct Req
+    {
+        Sem sem_;
+        int32_t res_ = 0;
+    };
+
+    /*
+    初始化，失败则返回false，由调用者回退到线程池模式
+    失败时已经申请的资源不做释放（fd和映射内存），因为初始化每个线程只做一次
+    */
+    bool Init()
+    {
+        static const unsigned kEntryCount = 256;
+
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, kEntryCount, &params));
+        if (ring_fd_ < 0)
+        {
+            return false;
+        }
+        fcntl(ring_fd_, F_SETFD, FD_CLOEXEC);
+
+        if (!Probe())
+        {
+            return false;
+        }
+
+        size_t sq_ring_sz = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        size_t cq_ring_sz = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap)
+        {
+            sq_ring_sz = cq_ring_sz = std::max(sq_ring_sz, cq_ring_sz);
+        }
+
+        auto sq_ring = reinterpret_cast<char *>(mmap(
+            nullptr, sq_ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING));
+        if (sq_ring == MAP_FAILED)
+        {
+            return false;
+        }
+        char *cq_ring = sq_ring;
+        if (!single_mmap)
+        {
+            cq_ring = reinterpret_cast<char *>(mmap(
+                nullptr, cq_ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ring_fd_, IORING_OFF_CQ_RING));
+            if (cq_ring == MAP_FAILED)
+            {
+                return false;
+            }
+        }
+        auto sqes = mmap(
+            nullptr, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        sq_head_    = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.head);
+        sq_tail_    = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.tail);
+        sq_mask_    = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.ring_mask);
+        sq_array_   = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.array);
+        sqes_       = reinterpret_cast<struct io_uring_sqe *>(sqes);
+        cq_head_    = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.head);
+        cq_tail_    = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.tail);
+        cq_mask_    = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.ring_mask);
+        cqes_       = reinterpret_cast<struct io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+
+        event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd_ == -1)
+        {
+            return false;
+        }
+        if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_EVENTFD, &event_fd_, 1) < 0)
+        {
+            return false;
+        }
+
+        inflight_sem_ = Sem::New(params.cq_entries);
+
+        Create(
+            [this] () {
+                Serve();
+            });
+
+        return true;
+    }
+
+    /*
+    提交一个请求并等待完成，prep用于填充sqe，返回值同系统调用风格（结果或-errno），提交失败返回-errno
+    */
+    int32_t Submit(std::function<void (struct io_uring_sqe *sqe)> prep)
+    {
+        int ret = inflight_sem_.Acquire(1);
+        Assert(ret == 0);
+        Defer defer_release_inflight(
+            [this] () {
+                inflight_sem_.Release(1);
+            });
+
+        Req req;
+        req.sem_ = Sem::New(0);
+        Defer defer_destroy_sem(
+            [&req] () {
+                ErrProtector ep;
+                req.sem_.Destroy();
+            });
+
+        //每次都是立即提交，且只有当前线程操作提交队列，所以队列不会满
+        unsigned tail = *sq_tail_;
+        Assert(tail == __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE));
+        unsigned idx = tail & *sq_mask_;
+        struct io_uring_sqe *sqe = &sqes_[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        prep(sqe);
+        sqe->user_data = reinterpret_cast<uint64_t>(&req);
+        sq_array_[idx] = idx;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+        long submitted;
+        do
+        {
+            submitted = syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0);
+        } while (submitted < 0 && errno == EINTR);
+        if (submitted != 1)
+        {
+            int err = submitted < 0 ? errno : EAGAIN;
+            if (__atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == tail)
+            {
+                //内核没有消费这个sqe，撤回
+                __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+                return -err;
+            }
+        }
+
+        ret = req.sem_.Acquire(1);
+        Assert(ret == 0);
+        return req.res_;
+    }
+};
+
+static IOUring *GetIOUring()
+{
+    AssertInited();
+    static thread_local bool inited = false;
+    static thread_local IOUring *uring = nullptr;
+    if (!inited)
+    {
+        inited = true;
+        if (!file_io_uring_disabled)
+        {
+            auto u = new IOUring();
+            if (u->Init())
+            {
+                uring = u;
+            }
+        }
+    }
+    return uring;
+}
+
+void DisableFileIOUring()
+{
+    file_io_uring_disabled = true;
+}
+
+bool IsFileIOUringUsed()
+{
+    return GetIOUring() != nullptr;
+}
+
+/*
+执行文件操作，io_uring可用时通过prep提交给io_uring，否则在线程池中执行sys_call
+返回值为系统调用风格的结果或-errno
+*/
+static int64_t DoFileOp(
+    std::function<void (struct io_uring_sqe *sqe)> prep, std::function<int64_t ()> sys_call)
+{
+    IOUring *uring = GetIOUring();
+    if (uring != nullptr)
+    {
+        return uring->Submit(prep);
+    }
+
+    int64_t res;
+    int ret = Offload(
+        [&res, &sys_call] () {
+            do
+            {
+                res = sys_call();
+            } while (res == -1 && errno == EINTR);
+            if (res == -1)
+            {
+                res = -errno;
+            }
+        });
+    Assert(ret == 0);
+    return res;
+}
+
+#define LOM_FIBER_FILE_CHECK_VALID_AND_SIZE(_sz) do {   \
+    if (!Valid()) {                                     \
+        SetError("invalid file");                       \
+        return err_code::kInvalid;                      \
+    }                                                   \
+    if ((_sz) < 0 || off < 0) {                         \
+        SetError("negative size or offset");            \
+        return err_code::kInvalid;                      \
+    }                                                   \
+} while (false)
+
+#define LOM_FIBER_FILE_RETURN_RESULT(_err_msg) do {     \
+    if (res < 0) {                                      \
+        errno = static_cast<int>(-res);                 \
+        SetError(_err_msg);                             \
+        return err_code::kSysCallFailed;                \
+    }                                                   \
+    return res;                                         \
+} while (false)
+
+ssize_t File::PRead(char *buf, ssize_t sz, int64_t off) const
+{
+    LOM_FIBER_FILE_CHECK_VALID_AND_SIZE(sz);
+
+    if (sz == 0)
+    {
+        return 0;
+    }
+
+    int fd = fd_;
+    //io_uring的单次读写长度是32位的
+    unsigned len = static_cast<unsigned>(std::min<ssize_t>(sz, 1 << 30));
+    int64_t res = DoFileOp(
+        [fd, buf, len, off] (struct io_uring_sqe *sqe) {
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buf);
+            sqe->len = len;
+            sqe->off = static_cast<uint64_t>(off);
+        },
+        [fd, buf, len, off] () -> int64_t {
+            return pread(fd, buf, len, off);
+        });
+    LOM_FIBER_FILE_RETURN_RESULT("pread failed");
+}
+
+ssize_t File::PWrite(const char *buf, ssize_t sz, int64_t off) const
+{
+    LOM_FIBER_FILE_CHECK_VALID_AND_SIZE(sz);
+
+    if (sz == 0)
+    {
+        return 0;
+    }
+
+    int fd = fd_;
+    unsigned len = static_cast<unsigned>(std::min<ssize_t>(sz, 1 << 30));
+    int64_t res = DoFileOp(
+        [fd, buf, len, off] (struct io_uring_sqe *sqe) {
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buf);
+            sqe->len = len;
+            sqe->off = static_cast<uint64_t>(off);
+        },
+        [fd, buf, len, off] () -> int64_t {
+            return pwrite(fd, buf, len, off);
+        });
+    LOM_FIBER_FILE_RETURN_RESULT("pwrite failed");
+}
+
+int File::PWriteAll(const char *buf, ssize_t sz, int64_t off) const
+{
+    LOM_FIBER_FILE_CHECK_VALID_AND_SIZE(sz);
+
+    while (sz > 0)
+    {
+        ssize_t ret = PWrite(buf, sz, off);
+        if (ret < 0)
+        {
+            return static_cast<int>(ret);
+        }
+        if (ret == 0)
+        {
+            //模拟为一个syscall的返回行为
+            errno = EIO;
+            SetError("pwrite returns 0");
+            return err_code::kSysCallFailed;
+        }
+        Assert(ret <= sz);
+        buf += ret;
+        sz -= ret;
+        off += ret;
+    }
+    return 0;
+}
+
+int File::Fsync(bool data_only) const
+{
+    int64_t off = 0;
+    LOM_FIBER_FILE_CHECK_VALID_AND_SIZE(0);
+
+    int fd = fd_;
+    int64_t res = DoFileOp(
+        [fd, data_only] (struct io_uring_sqe *sqe) {
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = fd;
+            sqe->fsync_flags = data_only ? IORING_FSYNC_DATASYNC : 0;
+        },
+        [fd, data_only] () -> int64_t {
+            return data_only ? fdatasync(fd) : fsync(fd);
+        });
+    LOM_FIBER_FILE_RETURN_RESULT("fsync failed");
+}
+
+int File::Fallocate(int64_t off, int64_t len, int mode) const
+{
+    LOM_FIBER_FILE_CHECK_VALID_AND_SIZE(len);
+
+    int fd = fd_;
+    int64_t res = DoFileOp(
+        [fd, off, len, mode] (struct io_uring_sqe *sqe) {
+            sqe->opcode = IORING_OP_FALLOCATE;
+            sqe->fd = fd;
+            sqe->off = static_cast<uint64_t>(off);
+            sqe->addr = static_cast<uint64_t>(len);
+            sqe->len = static_cast<uint32_t>(mode);
+        },
+        [fd, off, len, mode] () -> int64_t {
+            return fallocate(fd, mode, off, len);
+        });
+    LOM_FIBER_FILE_RETURN_RESULT("fallocate failed");
+}
+
+#undef LOM_FIBER_FILE_CHECK_VALID_AND_SIZE
+#undef LOM_FIBER_FILE_RETURN_RESULT
+
+bool File::Close() const
+{
+    if (!Valid())
+    {
+        SetError("invalid file");
+        return false;
+    }
+    if (close(fd_) == -1)
+    {
+        SetError("close file failed");
+        return false;
+    }
+    return true;
+}
+
+io::BufReader::Ptr File::NewBufReader(int64_t off, ssize_t buf_sz) const
+{
+    File file = *this;
+    auto pos = std::make_shared<int64_t>(off);
+    return io::BufReader::New(
+        [file, pos] (char *buf, ssize_t sz) -> ssize_t {
+            ssize_t ret = file.PRead(buf, sz, *pos);
+            if (ret > 0)
+            {
+                *pos += ret;
+            }
+            return ret;
+        },
+        buf_sz);
+}
+
+io::BufWriter::Ptr File::NewBufWriter(int64_t off, ssize_t buf_sz) const
+{
+    File file = *this;
+    auto pos = std::make_shared<int64_t>(off);
+    return io::BufWriter::New(
+        [file, pos] (const char *buf, ssize_t sz) -> ssize_t {
+            ssize_t ret = file.PWrite(buf, sz, *pos);
+            if (ret == 0)
+            {
+                errno = EIO;
+                SetError("pwrite returns 0");
+                return err_code::kSysCallFailed;
+            }
+            if (ret > 0)
+            {
+                *pos += ret;
+            }
+            return ret;
+        },
+        buf_sz);
+}
+
+File File::Open(const char *path, int flags, int mode)
+{
+    AssertInited();
+
+    int fd;
+    int save_errno;
+    int ret = Offload(
+        [&fd, &save_errno, path, flags, mode] () {
+            do
+            {
+                fd = open(path, flags | O_CLOEXEC, mode);
+            } while (fd == -1 && errno == EINTR);
+            save_errno = errno;
+        });
+    Assert(ret == 0);
+
+    File file;
+    if (fd == -1)
+    {
+        errno = save_errno;
+        SetError(Sprintf("open file [%s] failed", path));
+        return file;
+    }
+    file.fd_ = fd;
+    return file;
+}
+
+File File::FromRawFd(int fd)
+{
+    File file;
+    file.fd_ = fd;
+    return file;
+}
+
+}
+
+}
@@ -15,7 +15,36 @@ void AssertInited();
 bool InitFdEnv();
 bool InitSched();
 
-bool RegRawFdToSched(int fd);
+/*
+fd表的表项，以fd为索引，除了用于判断Fd对象有效性的seq外，还记录了fd的可读写状态：
+    由于epoll是边缘触发模式，在系统调用返回EAGAIN后，直到下一个对应的epoll事件到来前，fd都必然不可读写，
+    流式socket的读写没有完成请求的全部长度时也是如此（缓冲已被读空或写满），
+    因此在这些情况下清除就绪状态，在epoll事件到来时设置，I/O接口在fd已知不就绪时可直接进入等待，
+    省掉一次必然返回EAGAIN的系统调用
+    读不满即读空的规则只对流式fd（SOCK_STREAM的socket和管道）成立，由注册时记录的stream_判断，
+    数据报、seqpacket、终端等fd的一次读只返回一个消息或一行，不满不代表没有剩余数据，只能依赖EAGAIN
+    例外是对端关闭或出错：其事件可能和最后一段数据合并成一次通知，读空数据后依然可读（读到EOF或错误），
+    所以收到这类事件后不再根据读取长度清除可读状态
+*/
+struct FdInfo
+{
+    uint32_t seq_ = 0;
+    bool r_ready_ = true;
+    bool w_ready_ = true;
+    bool hup_ = false;
+    bool stream_ = false;
+
+    //连接的I/O统计，未开启时为nullptr
+    ConnStats *stats_ = nullptr;
+};
+FdInfo &GetFdInfo(int fd);
+
+//释放fd表项上的连接统计（若有），在fd注册和注销时调用
+void FreeConnStats(int fd);
+bool IsConnStatsEnabledByDefault();
+void OnIOSysCallSkipped();
+
+bool RegRawFdToSched(int fd, bool exclusive = false);
 bool UnregRawFdFromSched(int fd);
 
 void RegSemToSched(Sem sem, uint64_t value);
@@ -25,6 +54,15 @@ uint64_t TryAcquireSem(Sem sem, uint64_t acquire_value);
 void RestoreAcquiringSem(Sem sem, uint64_t acquiring_value);
 int ReleaseSem(Sem sem, uint64_t release_value);
 
+/*
+跨线程唤醒机制，用于其他线程的任务完成后唤醒本线程中等待的fiber：
+GetCurrThreadNotifier获取当前调度线程的通知器（首次调用时创建），之后其他线程可通过NotifyReleaseSem
+对本线程的sem做Release(1)
+*/
+class ThreadNotifier;
+ThreadNotifier *GetCurrThreadNotifier();
+void NotifyReleaseSem(ThreadNotifier *notifier, Sem sem);
+
 struct WaitingEvents
 {
     int64_t expire_at_ = -1; //-1表示没设置超时事件
@@ -41,11 +79,67 @@ struct WaitingEvents
 };
 
 void SwitchToSchedFiber(const WaitingEvents &evs);
+//在当前无栈任务中登记等待事件，不切换，任务随后从resume函数返回即让出
+void WaitInStackless(const WaitingEvents &evs);
+
+//唤醒等待中的fiber的原因
+enum WakeUpSrc : uint8_t
+{
+    kWakeUpByTimeout,
+    kWakeUpByFdR,
+    kWakeUpByFdW,
+    kWakeUpByFdUnreg,
+    kWakeUpBySem,
+    kWakeUpBySemDestroy,
+};
+
+/*
+调度事件记录，参数含义随事件类型不同：
+    - SwitchIn：无
+    - SwitchOut：arg0表示fiber是否已结束
+    - Wait：arg0为等待原因的位组合（kSchedTraceWaitFor*），arg1为等待的第一个fd，没有则为-1
+    - WakeUp：arg0为WakeUpSrc，arg1为相关的fd，没有则为-1
+    - PollBegin：arg0为epoll_wait的超时时间
+    - PollEnd：arg0为epoll_wait返回的事件数
+记录开关是thread_local变量，关闭时每个记录点的开销只是一次判断
+*/
+enum SchedTraceEvType : uint8_t
+{
+    kSchedTraceSwitchIn,
+    kSchedTraceSwitchOut,
+    kSchedTraceWait,
+    kSchedTraceWakeUp,
+    kSchedTracePollBegin,
+    kSchedTracePollEnd,
+};
+static const int64_t
+    kSchedTraceWaitForTimeout   = 1,
+    kSchedTraceWaitForFdR       = 2,
+    kSchedTraceWaitForFdW       = 4,
+    kSchedTraceWaitForSem       = 8;
+
+extern thread_local bool sched_trace_on;
+void RecordSchedTraceEv(SchedTraceEvType type, int64_t fiber_seq, int64_t arg0 = 0, int64_t arg1 = -1);
+
+#define LOM_FIBER_SCHED_TRACE(...) do { \
+    if (sched_trace_on) {               \
+        RecordSchedTraceEv(__VA_ARGS__);\
+    }                                   \
+} while (false)
+
+//执行所有到期的定时器回调，由调度器调用
+void ProcessTimers(int64_t now);
+//返回最早的定时器队列项的时间，没有则返回-1，可能早于实际触发时间，调度器据此决定epoll_wait的超时
+int64_t NextTimerExpireAt();
 
 class Fiber
 {
     std::function<void ()> run_;
 
+    //无栈任务的恢复函数和参数，普通fiber为nullptr
+    stackless::ResumeFunc resume_ = nullptr;
+    void *resume_arg_ = nullptr;
+
     bool finished_ = false;
 
     jmp_buf ctx_;
@@ -56,15 +150,32 @@ class Fiber
 
     WaitingEvents waiting_evs_;
 
-    static void Start();
+    //fiber局部存储的槽位，第一次设置时分配，长度为kFiberLocalKeyCountMax
+    void **local_slots_ = nullptr;
+
+    //创建位置和运行时间统计，运行时间是每次被调度执行到切出的时长之和
+    CodePos create_pos_;
+    int64_t run_ns_ = 0;
+    int64_t run_ns_max_ = 0;
+    int64_t switch_in_count_ = 0;
+
+    //本线程所有存活的fiber组成的双向链表，用于统计
+    Fiber *prev_ = nullptr;
+    Fiber *next_ = nullptr;
 
-    Fiber(std::function<void ()> run, ssize_t stk_sz);
+    Fiber(std::function<void ()> run, ssize_t stk_sz, CodePos create_pos);
+    Fiber(stackless::ResumeFunc resume, void *resume_arg, CodePos create_pos);
+
+    void LinkToLiveFibers();
 
     Fiber(const Fiber&) = delete;
     Fiber& operator=(const Fiber&) = delete;
 
 public:
 
+    //fiber的入口，只由fiber.cpp中的汇编入口lom_fiber_entry调用
+    static void Start();
+
     ~Fiber();
 
     bool IsFinished() const
@@ -77,6 +188,20 @@ public:
         return &ctx_;
     }
 
+    bool IsStackless() const
+    {
+        return resume_ != nullptr;
+    }
+
+    //调度无栈任务，由调度器调用
+    void Resume()
+    {
+        resume_(resume_arg_);
+    }
+
+    //标记无栈任务结束，清理局部存储，调度器在本次Resume返回后释放它
+    void FinishStackless();
+
     int64_t Seq() const
     {
         return seq_;
@@ -87,15 +212,70 @@ public:
         return waiting_evs_;
     }
 
-    static Fiber *New(std::function<void ()> run, ssize_t stk_sz);
+    void *LocalSlot(ssize_t key) const
+    {
+        return local_slots_ == nullptr ? nullptr : local_slots_[key];
+    }
+
+    void SetLocalSlot(ssize_t key, void *v);
+
+    //对所有非空槽位调用对应的destructor并清空，在fiber的入口函数结束后调用
+    void ClearLocalSlots();
+
+    const CodePos &CreatePos() const
+    {
+        return create_pos_;
+    }
+
+    void OnSwitchedOut(int64_t run_ns)
+    {
+        run_ns_ += run_ns;
+        run_ns_max_ = std::max(run_ns_max_, run_ns);
+        ++ switch_in_count_;
+    }
+
+    FiberStat Stat() const;
+
+    //返回本线程存活fiber链表的头，通过Next遍历
+    static Fiber *LiveFibers();
+
+    Fiber *Next() const
+    {
+        return next_;
+    }
+
+    static Fiber *New(std::function<void ()> run, ssize_t stk_sz, CodePos create_pos);
+    static Fiber *NewStackless(stackless::ResumeFunc resume, void *resume_arg, CodePos create_pos);
 
     void Destroy();
 };
 
+/*
+调度器在切入和切出fiber时调用，用于统计fiber的运行时间和看门狗检测
+OnSchedRunBegin和OnSchedRunEnd在Run开始和结束时调用，将本线程注册到看门狗或注销
+*/
+void OnSchedRunBegin();
+void OnSchedRunEnd();
+int64_t OnFiberSwitchIn(Fiber *fiber);
+void OnFiberSwitchOut(Fiber *fiber, int64_t switch_in_at);
+
+//切入fiber时开始新的时间片，清除抢占标记，若抢占定时器因空闲被暂停则重新开启
+void OnPreemptSliceBegin(int64_t now_ns);
+//调度器进入会阻塞的epoll_wait前调用，暂停抢占定时器，避免没有fiber运行时也被信号周期性唤醒
+void OnSchedIdleBegin();
+
 void RegFiber(Fiber *fiber);
 Fiber *GetCurrFiber();
 jmp_buf *GetSchedCtx();
 
+bool SetRawSockOpts(int fd, const ConnSockOpts &opts);
+
+/*
+创建一个监听所有地址的TCP socket，返回fd，失败返回-1，fd未注册到调度器，因此可以在非fiber环境的线程中调用
+reuse_port为true时设置SO_REUSEPORT，incoming_cpu>=0时设置SO_INCOMING_CPU
+*/
+int ListenTCPRawFd(uint16_t port, bool reuse_port, int incoming_cpu);
+
 bool PathToUnixSockAddr(const char *path, struct sockaddr_un &addr, socklen_t &addr_len);
 bool AbstractPathToUnixSockAddr(const Str &path, struct sockaddr_un &addr, socklen_t &addr_len);
 
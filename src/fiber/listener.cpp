@@ -6,7 +6,7 @@ namespace lom
 namespace fiber
 {
 
-Conn Listener::Accept(int64_t timeout_ms, int *err_code) const
+Conn Listener::Accept(int64_t timeout_ms, int *err_code, const ConnSockOpts *opts) const
 {
 
 #define LOM_FIBER_LISTENER_ERR_RETURN(_err_msg, _err_code) do { \
@@ -26,15 +26,38 @@ Conn Listener::Accept(int64_t timeout_ms, int *err_code) const
 
     for (;;)
     {
-        int fd = accept(RawFd(), nullptr, nullptr);
+        int fd;
+        FdInfo &fd_info = GetFdInfo(RawFd());
+        if (fd_info.r_ready_)
+        {
+            fd = accept(RawFd(), nullptr, nullptr);
+        }
+        else
+        {
+            //已知没有待接收的连接，跳过系统调用直接等待
+            OnIOSysCallSkipped();
+            fd = -1;
+            errno = EAGAIN;
+        }
         if (fd >= 0)
         {
             Conn conn = Conn::FromRawFd(fd);
             if (conn.Valid())
             {
-                //set tcp nodelay as possible
-                int enable = 1;
-                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+                if (opts == nullptr || opts->no_delay_ < 0)
+                {
+                    //set tcp nodelay as possible
+                    int enable = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+                }
+
+                if (opts != nullptr && !conn.SetSockOpts(*opts))
+                {
+                    int save_errno = errno;
+                    conn.Close();
+                    errno = save_errno;
+                    LOM_FIBER_LISTENER_ERR_RETURN("set accepted connection socket options failed", kSysCallFailed);
+                }
 
                 if (err_code != nullptr)
                 {
@@ -66,6 +89,7 @@ Conn Listener::Accept(int64_t timeout_ms, int *err_code) const
         }
         if (errno == EAGAIN)
         {
+            fd_info.r_ready_ = false;
             WaitingEvents evs;
             evs.expire_at_ = expire_at;
             evs.waiting_fds_r_.emplace_back(RawFd());
@@ -88,7 +112,15 @@ Listener Listener::FromRawFd(int fd)
     return listener;
 }
 
-static Listener ListenStream(int socket_family, struct sockaddr *addr, socklen_t addr_len, int listen_fd = -1)
+Listener Listener::FromSharedRawFd(int fd)
+{
+    Listener listener;
+    listener.Reg(fd, true);
+    return listener;
+}
+
+//创建（若listen_fd<0）、绑定并监听socket，返回监听的fd，失败返回-1，传入的listen_fd在失败时也会被关闭
+static int ListenStreamRawFd(int socket_family, struct sockaddr *addr, socklen_t addr_len, int listen_fd = -1)
 {
     if (listen_fd < 0)
     {
@@ -96,14 +128,14 @@ static Listener ListenStream(int socket_family, struct sockaddr *addr, socklen_t
         if (listen_fd == -1)
         {
             SetError("create listen socket failed");
-            return Listener();
+            return -1;
         }
     }
 
 #define LOM_FIBER_LISTENER_ERR_RETURN(_err_msg) do {    \
     SetError(_err_msg);                                 \
     SilentClose(listen_fd);                             \
-    return Listener();                                  \
+    return -1;                                          \
 } while (false)
 
     if (bind(listen_fd, addr, addr_len) == -1)
@@ -118,6 +150,16 @@ static Listener ListenStream(int socket_family, struct sockaddr *addr, socklen_t
 
 #undef LOM_FIBER_LISTENER_ERR_RETURN
 
+    return listen_fd;
+}
+
+static Listener RawFdToListener(int listen_fd)
+{
+    if (listen_fd < 0)
+    {
+        return Listener();
+    }
+
     Listener listener = Listener::FromRawFd(listen_fd);
     if (!listener.Valid())
     {
@@ -127,22 +169,35 @@ static Listener ListenStream(int socket_family, struct sockaddr *addr, socklen_t
     return listener;
 }
 
-Listener ListenTCP(uint16_t port)
+int ListenTCPRawFd(uint16_t port, bool reuse_port, int incoming_cpu)
 {
     int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (listen_fd == -1)
     {
         SetError("create listen socket failed");
-        return Listener();
+        return -1;
     }
 
-    int reuseaddr_on = 1;
-    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuseaddr_on, sizeof(reuseaddr_on)) == -1)
+#define LOM_FIBER_LISTENER_SET_SOCK_OPT(_opt_name, _v, _err_msg) do {                 \
+    int v = (_v);                                                                       \
+    if (setsockopt(listen_fd, SOL_SOCKET, (_opt_name), &v, sizeof(v)) == -1) {          \
+        SetError(_err_msg);                                                             \
+        SilentClose(listen_fd);                                                         \
+        return -1;                                                                      \
+    }                                                                                   \
+} while (false)
+
+    LOM_FIBER_LISTENER_SET_SOCK_OPT(SO_REUSEADDR, 1, "set listen socket reuse-addr failed");
+    if (reuse_port)
     {
-        SetError("set listen socket reuse-addr failed");
-        SilentClose(listen_fd);
-        return Listener();
+        LOM_FIBER_LISTENER_SET_SOCK_OPT(SO_REUSEPORT, 1, "set listen socket reuse-port failed");
     }
+    if (incoming_cpu >= 0)
+    {
+        LOM_FIBER_LISTENER_SET_SOCK_OPT(SO_INCOMING_CPU, incoming_cpu, "set listen socket incoming-cpu failed");
+    }
+
+#undef LOM_FIBER_LISTENER_SET_SOCK_OPT
 
     struct sockaddr_in listen_addr;
     memset(&listen_addr, 0, sizeof(listen_addr));
@@ -150,10 +205,15 @@ Listener ListenTCP(uint16_t port)
     listen_addr.sin_addr.s_addr = INADDR_ANY;
     listen_addr.sin_port = htons(port);
 
-    return ListenStream(
+    return ListenStreamRawFd(
         AF_INET, reinterpret_cast<struct sockaddr *>(&listen_addr), sizeof(listen_addr), listen_fd);
 }
 
+Listener ListenTCP(uint16_t port)
+{
+    return RawFdToListener(ListenTCPRawFd(port, false, -1));
+}
+
 Listener ListenUnixSockStream(const char *path)
 {
     struct sockaddr_un addr;
@@ -163,7 +223,7 @@ Listener ListenUnixSockStream(const char *path)
         return Listener();
     }
 
-    return ListenStream(AF_UNIX, reinterpret_cast<struct sockaddr *>(&addr), addr_len);
+    return RawFdToListener(ListenStreamRawFd(AF_UNIX, reinterpret_cast<struct sockaddr *>(&addr), addr_len));
 }
 
 Listener ListenUnixSockStreamWithAbstractPath(const Str &path)
@@ -175,7 +235,7 @@ Listener ListenUnixSockStreamWithAbstractPath(const Str &path)
         return Listener();
     }
 
-    return ListenStream(AF_UNIX, reinterpret_cast<struct sockaddr *>(&addr), addr_len);
+    return RawFdToListener(ListenStreamRawFd(AF_UNIX, reinterpret_cast<struct sockaddr *>(&addr), addr_len));
 }
 
 }
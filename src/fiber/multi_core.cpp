@@ -0,0 +1,219 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+static thread_local ssize_t curr_core_idx = -1;
+
+ssize_t CurrCoreIdx()
+{
+    return curr_core_idx;
+}
+
+//解析sysfs中形如“0-3,8,10-11”的列表，失败返回false
+static bool ParseSysIdList(const char *path, std::vector<int> &ids)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+    char buf[4096];
+    bool ok = fgets(buf, sizeof(buf), fp) != nullptr;
+    fclose(fp);
+    if (!ok)
+    {
+        return false;
+    }
+
+    GoSlice<StrSlice> items = StrSlice(buf).Trim().Split(",");
+    for (ssize_t i = 0; i < items.Len(); ++ i)
+    {
+        StrSlice item = items.At(i);
+        if (item.Len() == 0)
+        {
+            continue;
+        }
+        GoSlice<StrSlice> range = item.Split("-");
+        int64_t begin, end;
+        if (range.Len() > 2 ||
+            !range.At(0).ParseInt64(begin, 10) || !range.At(range.Len() - 1).ParseInt64(end, 10) ||
+            begin < 0 || begin > end || end >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        for (int64_t id = begin; id <= end; ++ id)
+        {
+            ids.emplace_back(static_cast<int>(id));
+        }
+    }
+    return true;
+}
+
+struct CpuNode
+{
+    int cpu_;
+    int numa_node_;
+};
+
+//获取调用线程可用的CPU列表，按NUMA节点排序，无法获取节点信息时节点为-1
+static bool GetAvailableCpus(std::vector<CpuNode> &cpus)
+{
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == -1)
+    {
+        SetError("sched_getaffinity failed");
+        return false;
+    }
+
+    std::map<int, int> cpu_nodes;
+    std::vector<int> nodes;
+    if (ParseSysIdList("/sys/devices/system/node/online", nodes))
+    {
+        for (int node : nodes)
+        {
+            std::vector<int> node_cpus;
+            if (ParseSysIdList(Sprintf("/sys/devices/system/node/node%d/cpulist", node).CStr(), node_cpus))
+            {
+                for (int cpu : node_cpus)
+                {
+                    cpu_nodes[cpu] = node;
+                }
+            }
+        }
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++ cpu)
+    {
+        if (CPU_ISSET(cpu, &cpu_set))
+        {
+            auto iter = cpu_nodes.find(cpu);
+            cpus.emplace_back(CpuNode{cpu, iter == cpu_nodes.end() ? -1 : iter->second});
+        }
+    }
+    if (cpus.empty())
+    {
+        SetError("no available cpu");
+        return false;
+    }
+
+    std::stable_sort(
+        cpus.begin(), cpus.end(),
+        [] (const CpuNode &a, const CpuNode &b) {
+            return a.numa_node_ < b.numa_node_;
+        });
+    return true;
+}
+
+static void RunCore(std::function<void (const CoreCtx &ctx)> init, CoreCtx ctx, int listen_fd, bool shared_listener)
+{
+    if (ctx.cpu_ >= 0)
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(ctx.cpu_, &cpu_set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (err != 0)
+        {
+            Die(Sprintf("lom::fiber::RunMultiCore: bind core [%zd] to cpu [%d] failed: %s",
+                        ctx.idx_, ctx.cpu_, strerror(err)));
+        }
+    }
+
+    MustInit();
+    curr_core_idx = ctx.idx_;
+
+    if (listen_fd >= 0)
+    {
+        ctx.listener_ = shared_listener ? Listener::FromSharedRawFd(listen_fd) : Listener::FromRawFd(listen_fd);
+        if (!ctx.listener_.Valid())
+        {
+            Die(Str("lom::fiber::RunMultiCore: register listener failed: ").Concat(Err()));
+        }
+    }
+
+    Create(
+        [init, ctx] () {
+            init(ctx);
+        });
+    Run();
+    Die(Str("lom::fiber::RunMultiCore: fiber sched exited: ").Concat(Err()));
+}
+
+bool RunMultiCore(std::function<void (const CoreCtx &ctx)> init, const MultiCoreOptions &opts)
+{
+    std::vector<CpuNode> cpus;
+    if (!GetAvailableCpus(cpus))
+    {
+        return false;
+    }
+
+    ssize_t thread_count = opts.thread_count_ > 0 ? opts.thread_count_ : static_cast<ssize_t>(cpus.size());
+
+    //准备阶段在调用线程中完成所有可能失败的操作，确保启动任何线程之前就能报告错误
+    std::vector<int> listen_fds;
+    Defer close_listen_fds(
+        [&listen_fds] () {
+            for (int fd : listen_fds)
+            {
+                SilentClose(fd);
+            }
+        });
+    if (opts.listen_port_ > 0)
+    {
+        ssize_t listen_fd_count = opts.shared_listener_ ? 1 : thread_count;
+        for (ssize_t i = 0; i < listen_fd_count; ++ i)
+        {
+            const CpuNode &cpu_node = cpus.at(static_cast<size_t>(i) % cpus.size());
+            int incoming_cpu = opts.pin_cpu_ && opts.incoming_cpu_ && !opts.shared_listener_ ? cpu_node.cpu_ : -1;
+            int fd = ListenTCPRawFd(opts.listen_port_, !opts.shared_listener_, incoming_cpu);
+            if (fd < 0)
+            {
+                return false;
+            }
+            listen_fds.emplace_back(fd);
+        }
+    }
+    std::vector<int> core_listen_fds;
+    core_listen_fds.swap(listen_fds);
+
+    std::vector<CoreCtx> ctxs;
+    for (ssize_t i = 0; i < thread_count; ++ i)
+    {
+        const CpuNode &cpu_node = cpus.at(static_cast<size_t>(i) % cpus.size());
+        CoreCtx ctx;
+        ctx.idx_ = i;
+        ctx.thread_count_ = thread_count;
+        if (opts.pin_cpu_)
+        {
+            ctx.cpu_ = cpu_node.cpu_;
+            ctx.numa_node_ = cpu_node.numa_node_;
+        }
+        ctxs.emplace_back(ctx);
+    }
+
+    auto core_listen_fd = [&core_listen_fds] (ssize_t idx) -> int {
+        if (core_listen_fds.empty())
+        {
+            return -1;
+        }
+        return core_listen_fds.size() == 1 ? core_listen_fds.at(0) : core_listen_fds.at(static_cast<size_t>(idx));
+    };
+
+    for (ssize_t i = 1; i < thread_count; ++ i)
+    {
+        std::thread(RunCore, init, ctxs.at(i), core_listen_fd(i), opts.shared_listener_).detach();
+    }
+    RunCore(init, ctxs.at(0), core_listen_fd(0), opts.shared_listener_);
+
+    //unreachable
+    return false;
+}
+
+}
+
+}
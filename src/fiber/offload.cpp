@@ -0,0 +1,234 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+跨线程唤醒的实现：
+每个调度线程有一个注册到本线程epoll的eventfd和一个待释放的Sem队列，其他线程将Sem入队并写eventfd，
+本线程的服务fiber读取eventfd后统一Release这些Sem，由此唤醒等待的fiber
+对象创建后不会销毁，因为其他线程可能还持有其指针
+*/
+class ThreadNotifier
+{
+    std::mutex lock_;
+    std::vector<Sem> sems_;
+    int event_fd_;
+
+    void Serve()
+    {
+        Conn ev_conn = Conn::FromRawFd(event_fd_);
+        if (!ev_conn.Valid())
+        {
+            Die(Str("lom::fiber: register notifier eventfd failed: ").Concat(Err()));
+        }
+
+        std::vector<Sem> sems;
+        for (;;)
+        {
+            uint64_t count;
+            ssize_t ret = ev_conn.Read(reinterpret_cast<char *>(&count), sizeof(count));
+            if (ret != sizeof(count))
+            {
+                Die(Str("lom::fiber: read notifier eventfd failed: ").Concat(Err()));
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                sems.swap(sems_);
+            }
+            for (Sem sem : sems)
+            {
+                sem.Release(1);
+            }
+            sems.clear();
+        }
+    }
+
+public:
+
+    ThreadNotifier()
+    {
+        event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd_ == -1)
+        {
+            Die("lom::fiber: create notifier eventfd failed");
+        }
+        Create(
+            [this] () {
+                Serve();
+            });
+    }
+
+    void ReleaseSem(Sem sem)
+    {
+        bool need_wake_up;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            //队列非空说明已经写过eventfd且服务fiber还没处理，不需要再写
+            need_wake_up = sems_.empty();
+            sems_.emplace_back(sem);
+        }
+        if (need_wake_up)
+        {
+            uint64_t count = 1;
+            ssize_t ret;
+            do
+            {
+                ret = write(event_fd_, &count, sizeof(count));
+            } while (ret == -1 && errno == EINTR);
+        }
+    }
+};
+
+ThreadNotifier *GetCurrThreadNotifier()
+{
+    AssertInited();
+    static thread_local ThreadNotifier *notifier = nullptr;
+    if (notifier == nullptr)
+    {
+        notifier = new ThreadNotifier();
+    }
+    return notifier;
+}
+
+void NotifyReleaseSem(ThreadNotifier *notifier, Sem sem)
+{
+    notifier->ReleaseSem(sem);
+}
+
+struct OffloadTask
+{
+    std::function<void ()> fn_;
+    int64_t submit_at_;
+    ThreadNotifier *notifier_;
+    Sem sem_;
+};
+
+//线程池相关的全局对象不析构，避免进程退出时析构正在被worker线程使用的对象
+static std::mutex &offload_lock = *new std::mutex;
+static std::condition_variable &offload_cond = *new std::condition_variable;
+static std::deque<OffloadTask *> &offload_tasks = *new std::deque<OffloadTask *>;
+static bool offload_started = false;
+static ssize_t offload_thread_count = 16;
+
+static std::atomic<int64_t>
+    stat_queue_len_max(0),
+    stat_running_count(0),
+    stat_done_count(0),
+    stat_wait_us_total(0),
+    stat_run_us_total(0),
+    stat_run_us_max(0);
+
+static void UpdateMax(std::atomic<int64_t> &m, int64_t v)
+{
+    int64_t curr = m.load();
+    while (v > curr && !m.compare_exchange_weak(curr, v))
+    {
+    }
+}
+
+static void OffloadWorker()
+{
+    for (;;)
+    {
+        OffloadTask *task;
+        {
+            std::unique_lock<std::mutex> lock(offload_lock);
+            while (offload_tasks.empty())
+            {
+                offload_cond.wait(lock);
+            }
+            task = offload_tasks.front();
+            offload_tasks.pop_front();
+            ++ stat_running_count;
+        }
+
+        int64_t start_at = NowClockUS();
+        task->fn_();
+        int64_t end_at = NowClockUS();
+
+        -- stat_running_count;
+        ++ stat_done_count;
+        stat_wait_us_total += start_at - task->submit_at_;
+        stat_run_us_total += end_at - start_at;
+        UpdateMax(stat_run_us_max, end_at - start_at);
+
+        //task归属于提交它的fiber，通知之后就可能被释放，不能再访问
+        NotifyReleaseSem(task->notifier_, task->sem_);
+    }
+}
+
+bool SetOffloadThreadCount(ssize_t thread_count)
+{
+    std::lock_guard<std::mutex> lock(offload_lock);
+    if (offload_started)
+    {
+        SetError("offload thread pool is already started");
+        return false;
+    }
+    offload_thread_count = std::min<ssize_t>(std::max<ssize_t>(thread_count, 1), 1024);
+    return true;
+}
+
+int Offload(std::function<void ()> fn)
+{
+    AssertInited();
+
+    OffloadTask task;
+    task.fn_ = fn;
+    task.notifier_ = GetCurrThreadNotifier();
+    task.sem_ = Sem::New(0);
+    Defer defer_destroy_sem(
+        [&task] () {
+            ErrProtector ep;
+            task.sem_.Destroy();
+        });
+
+    {
+        std::lock_guard<std::mutex> lock(offload_lock);
+        if (!offload_started)
+        {
+            for (ssize_t i = 0; i < offload_thread_count; ++ i)
+            {
+                std::thread(OffloadWorker).detach();
+            }
+            offload_started = true;
+        }
+        task.submit_at_ = NowClockUS();
+        offload_tasks.emplace_back(&task);
+        UpdateMax(stat_queue_len_max, static_cast<int64_t>(offload_tasks.size()));
+    }
+    offload_cond.notify_one();
+
+    /*
+    不设超时，直到fn执行完成被唤醒，task的sem只有这里使用，Acquire不会因为其他原因失败，
+    否则task可能在线程池还在使用的时候被释放了
+    */
+    int ret = task.sem_.Acquire(1);
+    Assert(ret == 0);
+    return 0;
+}
+
+OffloadStats GetOffloadStats()
+{
+    OffloadStats stats;
+    {
+        std::lock_guard<std::mutex> lock(offload_lock);
+        stats.queue_len_ = static_cast<int64_t>(offload_tasks.size());
+    }
+    stats.queue_len_max_ = stat_queue_len_max.load();
+    stats.running_count_ = stat_running_count.load();
+    stats.done_count_ = stat_done_count.load();
+    stats.wait_us_total_ = stat_wait_us_total.load();
+    stats.run_us_total_ = stat_run_us_total.load();
+    stats.run_us_max_ = stat_run_us_max.load();
+    return stats;
+}
+
+}
+
+}
@@ -0,0 +1,153 @@
+#include "internal.h"
+
+//旧版本的glibc没有定义这个字段名
+#ifndef sigev_notify_thread_id
+#   define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace lom
+{
+
+namespace fiber
+{
+
+/*
+以下变量由本线程和发给本线程的信号处理函数访问，都是线程本地的，不需要原子操作，
+slice_begin_at由调度器在切入fiber时更新，preempt_pending在切入fiber时清除
+*/
+static thread_local volatile int64_t preempt_slice_ns = 0;
+static thread_local volatile int64_t slice_begin_at = 0;
+static thread_local volatile sig_atomic_t preempt_pending = 0;
+
+static thread_local bool preempt_timer_created = false;
+static thread_local timer_t preempt_timer;
+static thread_local struct itimerspec preempt_timer_its;
+static thread_local bool preempt_timer_paused = false;
+static thread_local int64_t preempted_count = 0;
+
+static void PreemptSigHandler(int)
+{
+    int save_errno = errno;
+    int64_t slice_ns = preempt_slice_ns;
+    if (slice_ns > 0 && slice_begin_at > 0 && NowClockNS() - slice_begin_at >= slice_ns)
+    {
+        preempt_pending = 1;
+    }
+    errno = save_errno;
+}
+
+void OnPreemptSliceBegin(int64_t now_ns)
+{
+    slice_begin_at = now_ns;
+    preempt_pending = 0;
+    if (preempt_timer_paused)
+    {
+        //重新开始计时，第一次检查在半个时间片后
+        timer_settime(preempt_timer, 0, &preempt_timer_its, nullptr);
+        preempt_timer_paused = false;
+    }
+}
+
+void OnSchedIdleBegin()
+{
+    if (preempt_timer_created && !preempt_timer_paused)
+    {
+        struct itimerspec its;
+        memset(&its, 0, sizeof(its));
+        if (timer_settime(preempt_timer, 0, &its, nullptr) == 0)
+        {
+            preempt_timer_paused = true;
+        }
+    }
+}
+
+bool EnablePreempt(int64_t slice_ms, int sig)
+{
+    AssertInited();
+
+    if (slice_ms <= 0)
+    {
+        SetError("invalid preempt slice");
+        return false;
+    }
+
+    DisablePreempt();
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = PreemptSigHandler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(sig, &sa, nullptr) == -1)
+    {
+        SetError("install preempt signal handler failed");
+        return false;
+    }
+
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = sig;
+    sev.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+    if (timer_create(CLOCK_MONOTONIC, &sev, &preempt_timer) == -1)
+    {
+        SetError("create preempt timer failed");
+        return false;
+    }
+    preempt_timer_created = true;
+
+    //半个时间片检查一次，fiber最多多运行半个时间片才被标记
+    int64_t interval_ns = std::max<int64_t>(slice_ms * 1000 * 1000 / 2, 1000 * 1000);
+    struct itimerspec &its = preempt_timer_its;
+    its.it_interval.tv_sec = interval_ns / (1000 * 1000 * 1000);
+    its.it_interval.tv_nsec = interval_ns % (1000 * 1000 * 1000);
+    its.it_value = its.it_interval;
+
+    preempt_slice_ns = slice_ms * 1000 * 1000;
+    if (timer_settime(preempt_timer, 0, &its, nullptr) == -1)
+    {
+        SetError("start preempt timer failed");
+        DisablePreempt();
+        return false;
+    }
+
+    return true;
+}
+
+void DisablePreempt()
+{
+    preempt_slice_ns = 0;
+    preempt_pending = 0;
+    if (preempt_timer_created)
+    {
+        timer_delete(preempt_timer);
+        preempt_timer_created = false;
+    }
+    preempt_timer_paused = false;
+}
+
+void MaybeYield()
+{
+    if (!preempt_pending)
+    {
+        return;
+    }
+
+    Fiber *fiber = GetCurrFiber();
+    if (fiber == nullptr || fiber->IsStackless())
+    {
+        return;
+    }
+
+    ++ preempted_count;
+    Yield();
+}
+
+int64_t PreemptedCount()
+{
+    return preempted_count;
+}
+
+}
+
+}
@@ -0,0 +1,241 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+static const int kProfSampleDepthMax = 64;
+
+struct ProfSample
+{
+    int64_t tid_;
+    int64_t fiber_seq_;     //-1表示不在fiber中
+    int depth_;
+    void *pcs_[kProfSampleDepthMax];
+};
+
+/*
+样本区在启动时一次性申请，信号处理函数通过原子计数领取位置，因此不需要加锁，停止后才读取和释放
+信号处理函数在检查prof_on之前先增加prof_handler_count，返回前减少，停止时先清除prof_on，
+再等待prof_handler_count归零：之后到来的信号（包括定时器停止前已经产生、稍后才投递到其他线程的）
+必然看到prof_on为false而不访问样本区，因此可以安全地读取和释放
+*/
+static std::mutex &prof_lock = *new std::mutex;
+static std::atomic<bool> prof_on(false);
+static std::atomic<int64_t> prof_handler_count(0);
+static ProfSample *prof_samples = nullptr;
+static ssize_t prof_sample_count_max = 0;
+static std::atomic<ssize_t> prof_sample_count(0);
+
+static void ProfSigHandler(int)
+{
+    prof_handler_count.fetch_add(1);
+    if (!prof_on.load())
+    {
+        prof_handler_count.fetch_sub(1);
+        return;
+    }
+
+    int save_errno = errno;
+
+    ssize_t idx = prof_sample_count.fetch_add(1, std::memory_order_relaxed);
+    if (idx < prof_sample_count_max)
+    {
+        ProfSample &sample = prof_samples[idx];
+        sample.tid_ = static_cast<int64_t>(syscall(SYS_gettid));
+        Fiber *fiber = GetCurrFiber();
+        sample.fiber_seq_ = fiber == nullptr ? -1 : fiber->Seq();
+        sample.depth_ = backtrace(sample.pcs_, kProfSampleDepthMax);
+    }
+
+    errno = save_errno;
+    prof_handler_count.fetch_sub(1);
+}
+
+bool StartProfiler(int64_t hz, ssize_t sample_count_max)
+{
+    std::lock_guard<std::mutex> lock(prof_lock);
+    if (prof_samples != nullptr)
+    {
+        SetError("profiler is already started");
+        return false;
+    }
+
+    hz = std::min<int64_t>(std::max<int64_t>(hz, 1), 10000);
+    sample_count_max = std::max<ssize_t>(sample_count_max, 1);
+
+    /*
+    提前调用一次backtrace，使其依赖的库（libgcc_s）在正常上下文中完成加载，
+    否则第一次在信号处理函数中调用时会执行dlopen，和被中断的代码争用动态链接器的锁
+    */
+    static bool backtrace_primed = false;
+    if (!backtrace_primed)
+    {
+        void *frames[1];
+        backtrace(frames, 1);
+        backtrace_primed = true;
+    }
+
+    prof_samples = new ProfSample[sample_count_max];
+    prof_sample_count_max = sample_count_max;
+    prof_sample_count.store(0);
+    prof_on.store(true);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ProfSigHandler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+
+    //周期可能达到1秒，tv_usec必须小于1000000，需拆分到tv_sec
+    int64_t period_us = std::max<int64_t>(1000000 / hz, 1);
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    timer.it_interval.tv_sec = static_cast<time_t>(period_us / 1000000);
+    timer.it_interval.tv_usec = static_cast<suseconds_t>(period_us % 1000000);
+    timer.it_value = timer.it_interval;
+
+    struct sigaction old_sa;
+    bool sa_installed = sigaction(SIGPROF, &sa, &old_sa) == 0;
+    if (!sa_installed || setitimer(ITIMER_PROF, &timer, nullptr) == -1)
+    {
+        int save_errno = errno;
+        prof_on.store(false);
+        if (sa_installed)
+        {
+            //恢复原来的信号处理函数
+            sigaction(SIGPROF, &old_sa, nullptr);
+        }
+        while (prof_handler_count.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+        delete[] prof_samples;
+        prof_samples = nullptr;
+        errno = save_errno;
+        SetError("start profiling timer failed");
+        return false;
+    }
+
+    return true;
+}
+
+//将backtrace_symbols的输出“module(func+0x1f) [0x...]”转为“func”，没有函数名时为“module+0x...”
+static Str ProfFrameName(const char *sym)
+{
+    StrSlice s(sym);
+    ssize_t lp = s.IndexChar('('), plus = s.RIndexChar('+'), rp = s.RIndexChar(')');
+    if (lp < 0 || rp < lp)
+    {
+        return s.Slice(0, s.IndexChar(' ') < 0 ? s.Len() : s.IndexChar(' '));
+    }
+
+    StrSlice module = s.Slice(0, lp);
+    ssize_t slash = module.RIndexChar('/');
+    if (slash >= 0)
+    {
+        module = module.Slice(slash + 1);
+    }
+
+    if (plus < lp || plus > rp)
+    {
+        plus = rp;
+    }
+    Str mangled = s.Slice(lp + 1, plus - lp - 1);
+    if (mangled.Len() == 0)
+    {
+        return module.Concat(s.Slice(plus, rp - plus));
+    }
+
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(mangled.CStr(), nullptr, nullptr, &status);
+    if (demangled == nullptr)
+    {
+        return mangled;
+    }
+    Str name(demangled);
+    free(demangled);
+    //folded格式以分号分隔帧，以空格分隔次数，替换掉名字中的这两种字符
+    return name.Replace(";", ":").Replace(" ", "");
+}
+
+Str StopProfiler()
+{
+    std::lock_guard<std::mutex> lock(prof_lock);
+    if (prof_samples == nullptr)
+    {
+        return "";
+    }
+
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    prof_on.store(false);
+
+    //已经通过prof_on检查的信号处理函数可能还在执行，等待其全部返回
+    while (prof_handler_count.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+    ssize_t sample_count = std::min(prof_sample_count.load(), prof_sample_count_max);
+
+    //先对所有不同的地址解析符号，再按样本拼接
+    std::map<void *, Str> frame_names;
+    for (ssize_t i = 0; i < sample_count; ++ i)
+    {
+        const ProfSample &sample = prof_samples[i];
+        for (int j = 0; j < sample.depth_; ++ j)
+        {
+            frame_names.emplace(sample.pcs_[j], "");
+        }
+    }
+    std::vector<void *> pcs;
+    for (auto const &kv : frame_names)
+    {
+        pcs.emplace_back(kv.first);
+    }
+    if (!pcs.empty())
+    {
+        char **syms = backtrace_symbols(pcs.data(), static_cast<int>(pcs.size()));
+        for (size_t i = 0; i < pcs.size(); ++ i)
+        {
+            frame_names[pcs[i]] = syms == nullptr ? Sprintf("%p", pcs[i]) : ProfFrameName(syms[i]);
+        }
+        free(syms);
+    }
+
+    std::map<Str, int64_t> folded_counts;
+    for (ssize_t i = 0; i < sample_count; ++ i)
+    {
+        const ProfSample &sample = prof_samples[i];
+        Str::Buf stack;
+        stack.Append(Sprintf("thread-%lld;", static_cast<long long>(sample.tid_)));
+        stack.Append(
+            sample.fiber_seq_ < 0 ? Str("sched") : Sprintf("fiber-%lld", static_cast<long long>(sample.fiber_seq_)));
+        //第0帧是信号处理函数自身，第1帧是内核的信号返回跳板，跳过
+        for (int j = sample.depth_ - 1; j >= 2; -- j)
+        {
+            stack.Append(";");
+            stack.Append(frame_names[sample.pcs_[j]]);
+        }
+        ++ folded_counts[Str(std::move(stack))];
+    }
+
+    delete[] prof_samples;
+    prof_samples = nullptr;
+    prof_sample_count_max = 0;
+
+    Str::Buf result;
+    for (auto const &kv : folded_counts)
+    {
+        result.Append(kv.first);
+        result.Append(Sprintf(" %lld\n", static_cast<long long>(kv.second)));
+    }
+    return Str(std::move(result));
+}
+
+}
+
+}
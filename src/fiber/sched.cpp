@@ -30,7 +30,7 @@ struct SemInfo
 };
 static thread_local std::map<Sem, SemInfo> sem_infos;
 
-static void WakeUpFibers(const Fibers &fibers_to_wake_up)
+static void WakeUpFibers(const Fibers &fibers_to_wake_up, WakeUpSrc src, int64_t src_fd = -1)
 {
     //for each, add ready_fibers and remove from waiting queues
     for (auto fiber_iter = fibers_to_wake_up.begin(); fiber_iter != fibers_to_wake_up.end(); ++ fiber_iter)
@@ -38,6 +38,8 @@ static void WakeUpFibers(const Fibers &fibers_to_wake_up)
         int64_t fiber_seq = fiber_iter->first;
         Fiber *fiber = fiber_iter->second;
 
+        LOM_FIBER_SCHED_TRACE(kSchedTraceWakeUp, fiber_seq, src, src_fd);
+
         ready_fibers[fiber_seq] = fiber;
 
         WaitingEvents &evs = fiber->WaitingEvs();
@@ -156,7 +158,12 @@ Fiber *GetCurrFiber()
     return curr_fiber;
 }
 
-bool RegRawFdToSched(int fd)
+bool InFiber()
+{
+    return curr_fiber != nullptr;
+}
+
+bool RegRawFdToSched(int fd, bool exclusive)
 {
     if (io_waiting_fibers.find(fd) != io_waiting_fibers.end())
     {
@@ -165,7 +172,8 @@ bool RegRawFdToSched(int fd)
     }
 
     struct epoll_event ev;
-    ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+    //EPOLLEXCLUSIVE不能和EPOLLRDHUP一起使用，共享的listen fd也只需关注可读
+    ev.events = exclusive ? EPOLLIN | EPOLLET | EPOLLEXCLUSIVE : EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
     ev.data.fd = fd;
     if (epoll_ctl(ep_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
     {
@@ -187,7 +195,7 @@ bool UnregRawFdFromSched(int fd)
 #define LOM_FIBER_SCHED_WAKE_UP_ALL_FD_WAITING_FIBERS(_r_or_w) do {     \
     Fibers fibers_to_wake_up(std::move(fd_waiting_fibers._r_or_w##_));  \
     fd_waiting_fibers._r_or_w##_.clear();                               \
-    WakeUpFibers(fibers_to_wake_up);                                    \
+    WakeUpFibers(fibers_to_wake_up, kWakeUpByFdUnreg, fd);              \
 } while (false)
 
     LOM_FIBER_SCHED_WAKE_UP_ALL_FD_WAITING_FIBERS(r);
@@ -229,7 +237,7 @@ bool UnregSemFromSched(Sem sem)
 
     Fibers fibers_to_wake_up(std::move(sem_info.fibers_));
     sem_info.fibers_.clear();
-    WakeUpFibers(fibers_to_wake_up);
+    WakeUpFibers(fibers_to_wake_up, kWakeUpBySemDestroy);
 
     sem_infos.erase(sem_infos_iter);
     return true;
@@ -311,7 +319,7 @@ void RestoreAcquiringSem(Sem sem, uint64_t acquiring_value)
 
     Fibers fibers_to_wake_up(std::move(sem_info.fibers_));
     sem_info.fibers_.clear();
-    WakeUpFibers(fibers_to_wake_up);
+    WakeUpFibers(fibers_to_wake_up, kWakeUpBySem);
 }
 
 int ReleaseSem(Sem sem, uint64_t release_value)
@@ -335,14 +343,36 @@ int ReleaseSem(Sem sem, uint64_t release_value)
 
     Fibers fibers_to_wake_up(std::move(sem_info.fibers_));
     sem_info.fibers_.clear();
-    WakeUpFibers(fibers_to_wake_up);
+    WakeUpFibers(fibers_to_wake_up, kWakeUpBySem);
 
     return 0;
 }
 
-void SwitchToSchedFiber(const WaitingEvents &evs)
+static void RegCurrFiberWait(const WaitingEvents &evs)
 {
-    Assert(curr_fiber != nullptr);
+    if (sched_trace_on)
+    {
+        int64_t wait_for = 0, first_fd = -1;
+        if (evs.expire_at_ >= 0)
+        {
+            wait_for |= kSchedTraceWaitForTimeout;
+        }
+        if (!evs.waiting_fds_r_.empty())
+        {
+            wait_for |= kSchedTraceWaitForFdR;
+            first_fd = evs.waiting_fds_r_.front();
+        }
+        if (!evs.waiting_fds_w_.empty())
+        {
+            wait_for |= kSchedTraceWaitForFdW;
+            first_fd = first_fd >= 0 ? first_fd : evs.waiting_fds_w_.front();
+        }
+        if (!evs.waiting_sems_.empty())
+        {
+            wait_for |= kSchedTraceWaitForSem;
+        }
+        RecordSchedTraceEv(kSchedTraceWait, curr_fiber->Seq(), wait_for, first_fd);
+    }
 
     bool ok = RegCurrFiberWaitingEvs(evs);
     if (!ok)
@@ -350,6 +380,14 @@ void SwitchToSchedFiber(const WaitingEvents &evs)
         //empty evs, ready at once
         ready_fibers[curr_fiber->Seq()] = curr_fiber;
     }
+}
+
+void SwitchToSchedFiber(const WaitingEvents &evs)
+{
+    //无栈任务没有自己的栈，不能在其中调用fiber的阻塞接口
+    Assert(curr_fiber != nullptr && !curr_fiber->IsStackless());
+
+    RegCurrFiberWait(evs);
 
     if (setjmp(*curr_fiber->Ctx()) == 0)
     {
@@ -357,6 +395,12 @@ void SwitchToSchedFiber(const WaitingEvents &evs)
     }
 }
 
+void WaitInStackless(const WaitingEvents &evs)
+{
+    Assert(curr_fiber != nullptr && curr_fiber->IsStackless());
+    RegCurrFiberWait(evs);
+}
+
 void Yield()
 {
     AssertInited();
@@ -379,6 +423,11 @@ int SleepMS(int64_t ms)
 void Run()
 {
     AssertInited();
+    OnSchedRunBegin();
+    Defer on_run_end(
+        [] () {
+            OnSchedRunEnd();
+        });
     for (;;)
     {
         if (!ready_fibers.empty())
@@ -390,10 +439,16 @@ void Run()
                 Fiber *fiber = iter->second;
 
                 curr_fiber = fiber;
-                if (setjmp(sched_ctx) == 0)
+                int64_t switch_in_at = OnFiberSwitchIn(fiber);
+                if (fiber->IsStackless())
+                {
+                    fiber->Resume();
+                }
+                else if (setjmp(sched_ctx) == 0)
                 {
                     longjmp(*curr_fiber->Ctx(), 1);
                 }
+                OnFiberSwitchOut(fiber, switch_in_at);
                 curr_fiber = nullptr;
 
                 if (fiber->IsFinished())
@@ -417,8 +472,10 @@ void Run()
                 //pop and wake up
                 Fibers fibers_to_wake_up(std::move(iter->second));
                 expire_waiting_fibers.erase(iter);
-                WakeUpFibers(fibers_to_wake_up);
+                WakeUpFibers(fibers_to_wake_up, kWakeUpByTimeout);
             }
+
+            ProcessTimers(now);
         }
 
         //check io ev
@@ -431,10 +488,25 @@ void Run()
                 ep_wait_timeout = (
                     min_expire_at > now ? std::min(ep_wait_timeout, (int)(min_expire_at - now)) : 0);
             }
+            int64_t timer_expire_at = NextTimerExpireAt();
+            if (timer_expire_at >= 0)
+            {
+                int64_t now = NowMS();
+                ep_wait_timeout = (
+                    timer_expire_at > now ? std::min(ep_wait_timeout, (int)(timer_expire_at - now)) : 0);
+            }
 
             static const int kEpollEvCountMax = 1024;
             struct epoll_event evs[kEpollEvCountMax];
+            LOM_FIBER_SCHED_TRACE(kSchedTracePollBegin, 0, ep_wait_timeout);
+            LOM_SDT_PROBE1(epoll_wait_begin, ep_wait_timeout);
+            if (ep_wait_timeout != 0)
+            {
+                OnSchedIdleBegin();
+            }
             int ev_count = epoll_wait(ep_fd, evs, kEpollEvCountMax, ep_wait_timeout);
+            LOM_SDT_PROBE1(epoll_wait_end, ev_count);
+            LOM_FIBER_SCHED_TRACE(kSchedTracePollEnd, 0, ev_count);
             if (ev_count == -1)
             {
                 if (errno != EINTR)
@@ -458,17 +530,23 @@ void Run()
                         continue;
                     }
                     FdWaitingFibers &fd_waiting_fibers = fd_waiting_fibers_iter->second;
+                    FdInfo &fd_info = GetFdInfo(fd);
+                    if (ev.events & (EPOLLRDHUP | EPOLLERR | EPOLLHUP))
+                    {
+                        fd_info.hup_ = true;
+                    }
 
-#define LOM_FIBER_SCHED_WAKE_UP_BY_EVENT(_ev, _r_or_w) do {                 \
+#define LOM_FIBER_SCHED_WAKE_UP_BY_EVENT(_ev, _r_or_w, _src) do {           \
     if (ev.events & (EPOLL##_ev | EPOLLERR | EPOLLHUP)) {                   \
+        fd_info._r_or_w##_ready_ = true;                                    \
         Fibers fibers_to_wake_up(std::move(fd_waiting_fibers._r_or_w##_));  \
         fd_waiting_fibers._r_or_w##_.clear();                               \
-        WakeUpFibers(fibers_to_wake_up);                                    \
+        WakeUpFibers(fibers_to_wake_up, (_src), fd);                        \
     }                                                                       \
 } while (false)
 
-                    LOM_FIBER_SCHED_WAKE_UP_BY_EVENT(IN, r);
-                    LOM_FIBER_SCHED_WAKE_UP_BY_EVENT(OUT, w);
+                    LOM_FIBER_SCHED_WAKE_UP_BY_EVENT(IN, r, kWakeUpByFdR);
+                    LOM_FIBER_SCHED_WAKE_UP_BY_EVENT(OUT, w, kWakeUpByFdW);
 
 #undef LOM_FIBER_SCHED_WAKE_UP_BY_EVENT
 
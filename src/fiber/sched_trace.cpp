@@ -0,0 +1,200 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+thread_local bool sched_trace_on = false;
+
+struct SchedTraceEv
+{
+    int64_t ts_ns_;
+    int64_t fiber_seq_;
+    int64_t arg0_;
+    int64_t arg1_;
+    SchedTraceEvType type_;
+};
+
+//只由本线程读写，因此不需要加锁
+static thread_local std::vector<SchedTraceEv> *sched_trace_evs = nullptr;
+static thread_local uint64_t sched_trace_ev_count = 0;
+
+void RecordSchedTraceEv(SchedTraceEvType type, int64_t fiber_seq, int64_t arg0, int64_t arg1)
+{
+    SchedTraceEv &ev = (*sched_trace_evs)[sched_trace_ev_count % sched_trace_evs->size()];
+    ev.ts_ns_ = NowClockNS();
+    ev.fiber_seq_ = fiber_seq;
+    ev.arg0_ = arg0;
+    ev.arg1_ = arg1;
+    ev.type_ = type;
+    ++ sched_trace_ev_count;
+}
+
+void StartSchedTrace(ssize_t capacity)
+{
+    capacity = std::max<ssize_t>(capacity, 16);
+    if (sched_trace_evs == nullptr)
+    {
+        sched_trace_evs = new std::vector<SchedTraceEv>;
+    }
+    sched_trace_evs->assign(static_cast<size_t>(capacity), SchedTraceEv());
+    sched_trace_ev_count = 0;
+    sched_trace_on = true;
+}
+
+void StopSchedTrace()
+{
+    sched_trace_on = false;
+}
+
+static const char *WaitForStr(int64_t wait_for)
+{
+    static const char *const kStrs[] = {
+        "yield", "timeout", "fd_r", "fd_r+timeout", "fd_w", "fd_w+timeout", "fd_rw", "fd_rw+timeout",
+        "sem", "sem+timeout", "sem+fd_r", "sem+fd_r+timeout", "sem+fd_w", "sem+fd_w+timeout",
+        "sem+fd_rw", "sem+fd_rw+timeout",
+    };
+    return kStrs[wait_for & 15];
+}
+
+static const char *WakeUpSrcStr(int64_t src)
+{
+    switch (src)
+    {
+        case kWakeUpByTimeout:
+            return "timeout";
+        case kWakeUpByFdR:
+            return "fd_r";
+        case kWakeUpByFdW:
+            return "fd_w";
+        case kWakeUpByFdUnreg:
+            return "fd_closed";
+        case kWakeUpBySem:
+            return "sem";
+        case kWakeUpBySemDestroy:
+            return "sem_destroyed";
+    }
+    return "unknown";
+}
+
+Str DumpSchedTraceJSON()
+{
+    Str::Buf buf;
+    buf.Append("{\"traceEvents\":[");
+
+    int64_t pid = getpid();
+    int64_t tid_base = static_cast<int64_t>(syscall(SYS_gettid));
+    bool first = true;
+    auto append_ev = [&buf, &first] (const Str &ev) {
+        if (!first)
+        {
+            buf.Append(",\n");
+        }
+        first = false;
+        buf.Append(ev);
+    };
+
+    append_ev(Sprintf(
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lld,\"args\":{\"name\":\"lom sched thread %lld\"}}",
+        static_cast<long long>(pid), static_cast<long long>(tid_base)));
+    append_ev(Sprintf(
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lld,\"tid\":0,\"args\":{\"name\":\"sched\"}}",
+        static_cast<long long>(pid)));
+
+    //等待中的fiber的等待开始事件和唤醒事件，用于在其再次切入时生成等待区间
+    struct WaitInfo
+    {
+        const SchedTraceEv *wait_ev_ = nullptr;
+        const SchedTraceEv *wake_up_ev_ = nullptr;
+    };
+    std::map<int64_t, WaitInfo> wait_infos;
+    const SchedTraceEv *poll_begin_ev = nullptr;
+
+    uint64_t cap = sched_trace_evs == nullptr ? 0 : sched_trace_evs->size();
+    uint64_t begin = sched_trace_ev_count > cap ? sched_trace_ev_count - cap : 0;
+    for (uint64_t i = begin; i < sched_trace_ev_count; ++ i)
+    {
+        const SchedTraceEv &ev = (*sched_trace_evs)[i % cap];
+        double ts_us = static_cast<double>(ev.ts_ns_) / 1000;
+        long long seq = static_cast<long long>(ev.fiber_seq_);
+        switch (ev.type_)
+        {
+            case kSchedTraceSwitchIn:
+            {
+                auto iter = wait_infos.find(ev.fiber_seq_);
+                if (iter != wait_infos.end())
+                {
+                    const WaitInfo &wi = iter->second;
+                    if (wi.wait_ev_ != nullptr)
+                    {
+                        double wait_at_us = static_cast<double>(wi.wait_ev_->ts_ns_) / 1000;
+                        Str wake_up_args = wi.wake_up_ev_ == nullptr ? Str("") : Sprintf(
+                            ",\"wake_up_by\":\"%s\",\"wake_up_fd\":%lld,\"ready_delay_us\":%.3f",
+                            WakeUpSrcStr(wi.wake_up_ev_->arg0_), static_cast<long long>(wi.wake_up_ev_->arg1_),
+                            static_cast<double>(ev.ts_ns_ - wi.wake_up_ev_->ts_ns_) / 1000);
+                        append_ev(Sprintf(
+                            "{\"name\":\"wait\",\"ph\":\"X\",\"pid\":%lld,\"tid\":%lld,\"ts\":%.3f,\"dur\":%.3f,"
+                            "\"args\":{\"wait_for\":\"%s\",\"fd\":%lld%s}}",
+                            static_cast<long long>(pid), seq, wait_at_us, ts_us - wait_at_us,
+                            WaitForStr(wi.wait_ev_->arg0_), static_cast<long long>(wi.wait_ev_->arg1_),
+                            wake_up_args.CStr()));
+                    }
+                    wait_infos.erase(iter);
+                }
+                append_ev(Sprintf(
+                    "{\"name\":\"run\",\"ph\":\"B\",\"pid\":%lld,\"tid\":%lld,\"ts\":%.3f}",
+                    static_cast<long long>(pid), seq, ts_us));
+                break;
+            }
+            case kSchedTraceSwitchOut:
+            {
+                append_ev(Sprintf(
+                    "{\"name\":\"run\",\"ph\":\"E\",\"pid\":%lld,\"tid\":%lld,\"ts\":%.3f,\"args\":{\"finished\":%s}}",
+                    static_cast<long long>(pid), seq, ts_us, ev.arg0_ != 0 ? "true" : "false"));
+                break;
+            }
+            case kSchedTraceWait:
+            {
+                wait_infos[ev.fiber_seq_] = WaitInfo{&ev, nullptr};
+                break;
+            }
+            case kSchedTraceWakeUp:
+            {
+                auto iter = wait_infos.find(ev.fiber_seq_);
+                if (iter != wait_infos.end() && iter->second.wake_up_ev_ == nullptr)
+                {
+                    iter->second.wake_up_ev_ = &ev;
+                }
+                break;
+            }
+            case kSchedTracePollBegin:
+            {
+                poll_begin_ev = &ev;
+                break;
+            }
+            case kSchedTracePollEnd:
+            {
+                if (poll_begin_ev != nullptr)
+                {
+                    double begin_us = static_cast<double>(poll_begin_ev->ts_ns_) / 1000;
+                    append_ev(Sprintf(
+                        "{\"name\":\"epoll_wait\",\"ph\":\"X\",\"pid\":%lld,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,"
+                        "\"args\":{\"timeout_ms\":%lld,\"ev_count\":%lld}}",
+                        static_cast<long long>(pid), begin_us, ts_us - begin_us,
+                        static_cast<long long>(poll_begin_ev->arg0_), static_cast<long long>(ev.arg0_)));
+                    poll_begin_ev = nullptr;
+                }
+                break;
+            }
+        }
+    }
+
+    buf.Append("]}\n");
+    return Str(std::move(buf));
+}
+
+}
+
+}
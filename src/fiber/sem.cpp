@@ -16,14 +16,8 @@ bool Sem::Valid() const
     return seq_ >= 0 && IsSemInSched(*this);
 }
 
-int Sem::Acquire(uint64_t acquire_value, int64_t timeout_ms) const
+static int InternalAcquire(Sem sem, uint64_t acquire_value, int64_t timeout_ms)
 {
-    if (!Valid())
-    {
-        SetError("invalid sem");
-        return err_code::kInvalid;
-    }
-
     int64_t expire_at = timeout_ms < 0 ? -1 : NowMS() + timeout_ms;
 
     /*
@@ -34,7 +28,7 @@ int Sem::Acquire(uint64_t acquire_value, int64_t timeout_ms) const
     uint64_t done_value = 0;
     while (acquire_value > done_value)
     {
-        done_value += TryAcquireSem(*this, acquire_value - done_value);
+        done_value += TryAcquireSem(sem, acquire_value - done_value);
         if (done_value == acquire_value)
         {
             return 0;
@@ -47,7 +41,7 @@ int Sem::Acquire(uint64_t acquire_value, int64_t timeout_ms) const
             if (done_value > 0)
             {
                 //已经申请了一部分了，返还
-                RestoreAcquiringSem(*this, done_value);
+                RestoreAcquiringSem(sem, done_value);
             }
             SetError("timeout");
             return err_code::kTimeout;
@@ -55,10 +49,10 @@ int Sem::Acquire(uint64_t acquire_value, int64_t timeout_ms) const
 
         WaitingEvents evs;
         evs.expire_at_ = expire_at;
-        evs.waiting_sems_.emplace_back(*this);
+        evs.waiting_sems_.emplace_back(sem);
         SwitchToSchedFiber(evs);
 
-        if (!Valid())
+        if (!sem.Valid())
         {
             SetError("sem destroyed by another fiber");
             return err_code::kClosed;
@@ -68,8 +62,25 @@ int Sem::Acquire(uint64_t acquire_value, int64_t timeout_ms) const
     return 0;
 }
 
+int Sem::Acquire(uint64_t acquire_value, int64_t timeout_ms) const
+{
+    if (!Valid())
+    {
+        SetError("invalid sem");
+        return err_code::kInvalid;
+    }
+
+    MaybeYield();
+
+    LOM_SDT_PROBE2(sem_acquire_begin, acquire_value, timeout_ms);
+    int ret = InternalAcquire(*this, acquire_value, timeout_ms);
+    LOM_SDT_PROBE2(sem_acquire_end, acquire_value, ret);
+    return ret;
+}
+
 int Sem::Release(uint64_t release_value) const
 {
+    LOM_SDT_PROBE1(sem_release, release_value);
     return ReleaseSem(*this, release_value);
 }
 
@@ -0,0 +1,143 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+namespace stackless
+{
+
+void Create(ResumeFunc resume, void *arg, CodePos _cp)
+{
+    AssertInited();
+    Assert(resume != nullptr);
+    Fiber *fiber = Fiber::NewStackless(resume, arg, _cp);
+    LOM_SDT_PROBE2(fiber_create, fiber->Seq(), 0);
+    RegFiber(fiber);
+}
+
+bool InTask()
+{
+    Fiber *fiber = GetCurrFiber();
+    return fiber != nullptr && fiber->IsStackless();
+}
+
+#define LOM_FIBER_STACKLESS_WAIT(_waiting_field, _v) do {   \
+    WaitingEvents evs;                                      \
+    evs.expire_at_ = expire_at;                             \
+    evs._waiting_field.emplace_back(_v);                    \
+    WaitInStackless(evs);                                   \
+} while (false)
+
+void WaitFdR(int fd, int64_t expire_at)
+{
+    LOM_FIBER_STACKLESS_WAIT(waiting_fds_r_, fd);
+}
+
+void WaitFdW(int fd, int64_t expire_at)
+{
+    LOM_FIBER_STACKLESS_WAIT(waiting_fds_w_, fd);
+}
+
+void WaitSem(Sem sem, int64_t expire_at)
+{
+    LOM_FIBER_STACKLESS_WAIT(waiting_sems_, sem);
+}
+
+#undef LOM_FIBER_STACKLESS_WAIT
+
+void WaitUntil(int64_t expire_at)
+{
+    WaitingEvents evs;
+    evs.expire_at_ = expire_at;
+    WaitInStackless(evs);
+}
+
+void Finish()
+{
+    Fiber *fiber = GetCurrFiber();
+    Assert(fiber != nullptr);
+    fiber->FinishStackless();
+}
+
+uint64_t TryAcquire(Sem sem, uint64_t acquire_value)
+{
+    Assert(InTask());
+    return TryAcquireSem(sem, acquire_value);
+}
+
+void RestoreAcquiring(Sem sem, uint64_t acquiring_value)
+{
+    Assert(InTask());
+    RestoreAcquiringSem(sem, acquiring_value);
+}
+
+/*
+协程帧按64字节分级，每级缓存有上限，超过最大级别的直接走全局的new/delete
+空闲的帧本身用作链表节点
+*/
+static const size_t
+    kFrameSizeUnit      = 64,
+    kFrameClassCount    = 64;
+static const ssize_t kFrameCacheCountMaxPerClass = 1024;
+
+struct FreeFrameNode
+{
+    FreeFrameNode *next_;
+};
+
+struct FrameClass
+{
+    FreeFrameNode *free_list_ = nullptr;
+    ssize_t count_ = 0;
+};
+
+static thread_local FrameClass frame_classes[kFrameClassCount];
+
+void *AllocFrame(size_t sz)
+{
+    size_t cls = (sz + kFrameSizeUnit - 1) / kFrameSizeUnit;
+    if (cls == 0 || cls > kFrameClassCount)
+    {
+        return ::operator new(sz);
+    }
+
+    FrameClass &fc = frame_classes[cls - 1];
+    if (fc.free_list_ == nullptr)
+    {
+        return ::operator new(cls * kFrameSizeUnit);
+    }
+    FreeFrameNode *node = fc.free_list_;
+    fc.free_list_ = node->next_;
+    -- fc.count_;
+    return node;
+}
+
+void FreeFrame(void *p, size_t sz)
+{
+    size_t cls = (sz + kFrameSizeUnit - 1) / kFrameSizeUnit;
+    if (cls == 0 || cls > kFrameClassCount)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    FrameClass &fc = frame_classes[cls - 1];
+    if (fc.count_ >= kFrameCacheCountMaxPerClass)
+    {
+        ::operator delete(p);
+        return;
+    }
+    FreeFrameNode *node = static_cast<FreeFrameNode *>(p);
+    node->next_ = fc.free_list_;
+    fc.free_list_ = node;
+    ++ fc.count_;
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,140 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace fiber
+{
+
+class TimerImpl;
+
+/*
+定时器队列，按计划触发时间排序
+为了让推迟和停止都是O(1)的，队列中的项是惰性维护的：
+    - 定时器的实际触发时间expire_at_和其在队列中的位置queued_at_分开记录，
+      推迟时只修改expire_at_，等队列中的项到期时发现还没到实际触发时间再重新入队
+    - 停止时只将expire_at_设为-1，队列中的项到期时丢弃
+    - 只有提前触发时间时才需要插入新的项，旧的项的时间和queued_at_不一致，到期时作为过期项丢弃
+*/
+static thread_local std::multimap<int64_t, std::shared_ptr<TimerImpl>> timer_queue;
+
+class TimerImpl : public Timer, public std::enable_shared_from_this<TimerImpl>
+{
+    std::function<void ()> f_;
+    int64_t interval_ms_;   //0表示一次性定时器
+    int64_t expire_at_ = -1;
+    int64_t queued_at_ = -1;
+
+    void Schedule(int64_t ms)
+    {
+        expire_at_ = NowMS() + ms;
+        if (queued_at_ < 0 || queued_at_ > expire_at_)
+        {
+            queued_at_ = expire_at_;
+            timer_queue.emplace(queued_at_, shared_from_this());
+        }
+    }
+
+public:
+
+    TimerImpl(std::function<void ()> f, int64_t interval_ms) : f_(f), interval_ms_(interval_ms)
+    {
+    }
+
+    virtual bool Stop() override
+    {
+        bool pending = expire_at_ >= 0;
+        expire_at_ = -1;
+        return pending;
+    }
+
+    virtual bool Reset(int64_t ms) override
+    {
+        bool pending = expire_at_ >= 0;
+        if (interval_ms_ > 0)
+        {
+            interval_ms_ = std::max<int64_t>(ms, 1);
+        }
+        Schedule(std::max<int64_t>(ms, 0));
+        return pending;
+    }
+
+    //处理从队列中弹出的项，key为其在队列中的时间
+    void OnPopped(int64_t key, int64_t now)
+    {
+        if (key != queued_at_)
+        {
+            //过期项，定时器已经在队列中的其他位置了
+            return;
+        }
+        queued_at_ = -1;
+
+        if (expire_at_ < 0)
+        {
+            return;
+        }
+        if (expire_at_ > now)
+        {
+            //被推迟过，按实际触发时间重新入队
+            queued_at_ = expire_at_;
+            timer_queue.emplace(queued_at_, shared_from_this());
+            return;
+        }
+
+        //先更新状态再执行回调，使得回调中可以Stop或Reset自身
+        if (interval_ms_ > 0)
+        {
+            Schedule(interval_ms_);
+        }
+        else
+        {
+            expire_at_ = -1;
+        }
+        f_();
+    }
+};
+
+void ProcessTimers(int64_t now)
+{
+    while (!timer_queue.empty())
+    {
+        auto iter = timer_queue.begin();
+        int64_t key = iter->first;
+        if (key > now)
+        {
+            break;
+        }
+        std::shared_ptr<TimerImpl> timer = std::move(iter->second);
+        timer_queue.erase(iter);
+        timer->OnPopped(key, now);
+    }
+}
+
+int64_t NextTimerExpireAt()
+{
+    return timer_queue.empty() ? -1 : timer_queue.begin()->first;
+}
+
+static Timer::Ptr NewTimer(int64_t ms, int64_t interval_ms, std::function<void ()> f)
+{
+    AssertInited();
+
+    auto timer = std::make_shared<TimerImpl>(f, interval_ms);
+    timer->Reset(ms);
+    return timer;
+}
+
+Timer::Ptr AfterFunc(int64_t ms, std::function<void ()> f)
+{
+    return NewTimer(ms, 0, f);
+}
+
+Timer::Ptr NewTicker(int64_t interval_ms, std::function<void ()> f)
+{
+    interval_ms = std::max<int64_t>(interval_ms, 1);
+    return NewTimer(interval_ms, interval_ms, f);
+}
+
+}
+
+}
@@ -8,11 +8,20 @@
 #include <signal.h>
 #include <stddef.h>
 #include <setjmp.h>
+#include <sched.h>
+#include <pthread.h>
+#include <execinfo.h>
+#include <cxxabi.h>
 #include <endian.h>
 
 #include <sys/time.h>
 #include <unistd.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
 #include <sys/ioctl.h>
 #include <ucontext.h>
 #include <sys/types.h>
@@ -21,9 +30,18 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <linux/io_uring.h>
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <set>
 
 #include "../include/lom.h"
 
+#include "sdt.h"
+
 namespace lom
 {
 }
@@ -1,4 +1,4 @@
-#include "../internal.h"
+#include "internal.h"
 
 namespace lom
 {
@@ -11,13 +11,19 @@ static ssize_t AdjustBufSize(ssize_t sz)
     return std::min<ssize_t>(std::max<ssize_t>(sz, 4 * 1024), 4 * 1024 * 1024);
 }
 
-#define LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(_sz) do {  \
-        if (_sz <= 0) {                                 \
-            SetErr("non-positive size");                \
-            errno = EINVAL;                             \
-            return -1;                                  \
-        }                                               \
-    } while (false)
+//在[p, p+len)中查找end第一次出现的位置，单字节用memchr，多字节用memmem，都是按块扫描的
+static const char *FindEnd(const char *p, ssize_t len, const char *end, ssize_t end_len)
+{
+    if (len < end_len)
+    {
+        return nullptr;
+    }
+    if (end_len == 1)
+    {
+        return static_cast<const char *>(memchr(p, *end, static_cast<size_t>(len)));
+    }
+    return static_cast<const char *>(memmem(p, static_cast<size_t>(len), end, static_cast<size_t>(end_len)));
+}
 
 class BufReaderImpl : public BufReader
 {
@@ -33,6 +39,7 @@ class BufReaderImpl : public BufReader
         {
             start_ = 0;
             auto ret = do_read_(buf_, buf_sz_);
+            LOM_SDT_PROBE2(buf_reader_fill, buf_sz_, ret);
             if (ret < 0)
             {
                 return static_cast<int>(ret);
@@ -46,12 +53,89 @@ class BufReaderImpl : public BufReader
         return 0;
     }
 
-    ssize_t ReadFullOrUntil(char *buf, ssize_t sz, const char *end_ch)
+    //绕过缓冲直接读入调用者的buf
+    ssize_t ReadDirect(char *buf, ssize_t sz)
+    {
+        auto ret = do_read_(buf, sz);
+        LOM_SDT_PROBE2(buf_reader_fill, sz, ret);
+        Assert(ret <= sz);
+        return ret;
+    }
+
+    /*
+    在已有数据之后读入更多数据，返回值同下层读函数，供需要连续查看数据的接口使用
+    尾部没有空间或放不下want_len字节时先将数据整理到头部，还放不下则扩大缓冲
+    */
+    ssize_t FillMore(ssize_t want_len)
+    {
+        Assert(len_ < want_len);
+        if (start_ > 0 && start_ + want_len > buf_sz_)
+        {
+            memmove(buf_, buf_ + start_, len_);
+            start_ = 0;
+        }
+        if (want_len > buf_sz_)
+        {
+            ssize_t new_buf_sz = std::max(want_len, buf_sz_ * 2);
+            char *new_buf = new char[new_buf_sz];
+            memcpy(new_buf, buf_ + start_, len_);
+            delete[] buf_;
+            buf_ = new_buf;
+            buf_sz_ = new_buf_sz;
+            start_ = 0;
+        }
+
+        ssize_t tail = start_ + len_;
+        Assert(tail < buf_sz_);
+        auto ret = do_read_(buf_ + tail, buf_sz_ - tail);
+        LOM_SDT_PROBE2(buf_reader_fill, buf_sz_ - tail, ret);
+        if (ret > 0)
+        {
+            Assert(ret <= buf_sz_ - tail);
+            len_ += ret;
+        }
+        return ret;
+    }
+
+    //返回缓冲中长度为view_len的数据的视图，consume为true时同时消耗这些数据
+    StrSlice View(ssize_t view_len, bool consume)
+    {
+        StrSlice s(buf_ + start_, view_len);
+        if (consume)
+        {
+            start_ += view_len;
+            len_ -= view_len;
+        }
+        return s;
+    }
+
+    /*
+    读取直到读够sz或读到EOF，end不为nullptr时还会在读到end（长度end_len）后结束
+    先在调用者buf的尾部和本次数据的头部拼接处查找，以找到跨越两次读取的end，再在缓冲中查找，
+    这样每次只拷贝需要的数据，多字节的end被读取拆开时也能正确识别
+    */
+    ssize_t ReadFullOrUntil(char *buf, ssize_t sz, const char *end, ssize_t end_len)
     {
         LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(sz);
 
         for (ssize_t i = 0; i < sz;)
         {
+            if (end == nullptr && len_ == 0 && sz - i >= buf_sz_)
+            {
+                auto ret = ReadDirect(buf + i, sz - i);
+                if (ret < 0)
+                {
+                    return ret;
+                }
+                if (ret == 0)
+                {
+                    //EOF
+                    return i;
+                }
+                i += ret;
+                continue;
+            }
+
             int ret = Fill();
             if (ret < 0)
             {
@@ -64,30 +148,80 @@ class BufReaderImpl : public BufReader
             }
 
             auto fill_len = std::min(len_, sz - i);
-            bool is_end_ch_found = false;
-            if (end_ch != nullptr)
+            if (end != nullptr)
             {
-                for (ssize_t j = 0; j < fill_len; ++ j)
+                if (end_len > 1 && i > 0)
                 {
-                    if (buf_[start_ + j] == *end_ch)
+                    auto head_len = std::min(fill_len, end_len - 1);
+                    memcpy(buf + i, buf_ + start_, head_len);
+                    auto scan_from = std::max<ssize_t>(i - (end_len - 1), 0);
+                    auto p = FindEnd(buf + scan_from, i + head_len - scan_from, end, end_len);
+                    if (p != nullptr)
                     {
-                        fill_len = j + 1;
-                        is_end_ch_found = true;
-                        break;
+                        auto consume_len = p - buf + end_len - i;
+                        start_ += consume_len;
+                        len_ -= consume_len;
+                        return i + consume_len;
                     }
                 }
+
+                auto p = FindEnd(buf_ + start_, fill_len, end, end_len);
+                if (p != nullptr)
+                {
+                    fill_len = p - (buf_ + start_) + end_len;
+                    memcpy(buf + i, buf_ + start_, fill_len);
+                    start_ += fill_len;
+                    len_ -= fill_len;
+                    return i + fill_len;
+                }
             }
+
             memcpy(buf + i, buf_ + start_, fill_len);
             i += fill_len;
             start_ += fill_len;
             len_ -= fill_len;
-            if (is_end_ch_found)
+        }
+
+        return sz;
+    }
+
+    //ReadSlice的实现，参数含义同ReadFullOrUntil
+    ssize_t ReadSliceUntil(const char *end, ssize_t end_len, ssize_t sz, StrSlice &s)
+    {
+        LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(sz);
+
+        //已查找过的数据不再重复查找（除了可能是end前缀的尾部），整理缓冲不影响相对start_的偏移
+        ssize_t scanned_len = 0;
+        for (;;)
+        {
+            auto scan_end = std::min(len_, sz);
+            auto scan_from = std::max<ssize_t>(scanned_len - (end_len - 1), 0);
+            auto p = FindEnd(buf_ + start_ + scan_from, scan_end - scan_from, end, end_len);
+            if (p != nullptr)
             {
-                return i;
+                s = View(p - (buf_ + start_) + end_len, true);
+                return s.Len();
+            }
+            scanned_len = scan_end;
+            if (scanned_len == sz)
+            {
+                break;
+            }
+
+            auto ret = FillMore(len_ + 1);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            if (ret == 0)
+            {
+                //EOF
+                break;
             }
         }
 
-        return sz;
+        s = View(scanned_len, true);
+        return s.Len();
     }
 
 public:
@@ -106,6 +240,11 @@ public:
     {
         LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(sz);
 
+        if (len_ == 0 && sz >= buf_sz_)
+        {
+            return ReadDirect(buf, sz);
+        }
+
         int ret = Fill();
         if (ret < 0)
         {
@@ -124,12 +263,86 @@ public:
 
     virtual ssize_t ReadUntil(char end_ch, char *buf, ssize_t sz) override
     {
-        return ReadFullOrUntil(buf, sz, &end_ch);
+        return ReadFullOrUntil(buf, sz, &end_ch, 1);
+    }
+
+    virtual ssize_t ReadUntil(StrSlice end, char *buf, ssize_t sz) override
+    {
+        LOM_IO_CHECK_EMPTY_END_PARAM(end);
+        return ReadFullOrUntil(buf, sz, end.Data(), end.Len());
     }
 
     virtual ssize_t ReadFull(char *buf, ssize_t sz) override
     {
-        return ReadFullOrUntil(buf, sz, nullptr);
+        return ReadFullOrUntil(buf, sz, nullptr, 0);
+    }
+
+    virtual ssize_t Peek(ssize_t n, StrSlice &s) override
+    {
+        LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(n);
+
+        while (len_ < n)
+        {
+            auto ret = FillMore(n);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            if (ret == 0)
+            {
+                //EOF
+                break;
+            }
+        }
+
+        s = View(std::min(len_, n), false);
+        return s.Len();
+    }
+
+    virtual ssize_t ReadSlice(char end_ch, ssize_t sz, StrSlice &s) override
+    {
+        return ReadSliceUntil(&end_ch, 1, sz, s);
+    }
+
+    virtual ssize_t ReadSlice(StrSlice end, ssize_t sz, StrSlice &s) override
+    {
+        LOM_IO_CHECK_EMPTY_END_PARAM(end);
+        return ReadSliceUntil(end.Data(), end.Len(), sz, s);
+    }
+
+    virtual ssize_t Discard(ssize_t n) override
+    {
+        if (n < 0)
+        {
+            SetErr("negative size");
+            errno = EINVAL;
+            return -1;
+        }
+
+        ssize_t done = 0;
+        while (done < n)
+        {
+            int ret = Fill();
+            if (ret < 0)
+            {
+                return ret;
+            }
+            if (len_ == 0)
+            {
+                //EOF
+                break;
+            }
+            auto skip_len = std::min(len_, n - done);
+            start_ += skip_len;
+            len_ -= skip_len;
+            done += skip_len;
+        }
+        return done;
+    }
+
+    virtual ssize_t Buffered() const override
+    {
+        return len_;
     }
 };
 
@@ -141,6 +354,7 @@ BufReader::Ptr BufReader::New(BufReader::DoReadFunc do_read, ssize_t buf_sz)
 class BufWriterImpl : public BufWriter
 {
     BufWriter::DoWriteFunc do_write_;
+    BufWriter::DoWriteVFunc do_writev_;
     ssize_t buf_sz_;
     char *buf_;
     ssize_t start_ = 0;
@@ -152,6 +366,7 @@ class BufWriterImpl : public BufWriter
         auto send_len = std::min(len_, buf_sz_ - start_);
         Assert(send_len > 0);
         auto ret = do_write_(buf_ + start_, send_len);
+        LOM_SDT_PROBE2(buf_writer_flush, send_len, ret);
         if (ret < 0)
         {
             return static_cast<int>(ret);
@@ -169,10 +384,87 @@ class BufWriterImpl : public BufWriter
         return 0;
     }
 
+    //从缓冲中消耗已写出的n字节
+    void Consume(ssize_t n)
+    {
+        Assert(n <= len_);
+        start_ = (start_ + n) % buf_sz_;
+        len_ -= n;
+        if (len_ == 0)
+        {
+            start_ = 0;
+        }
+    }
+
+    //绕过缓冲直接写出大块数据，缓冲中已有的数据需要先写出，有批量写函数时和新数据合并写
+    int WriteDirect(const char *buf, ssize_t sz)
+    {
+        if (!do_writev_)
+        {
+            int ret = Flush();
+            if (ret != 0)
+            {
+                return ret;
+            }
+        }
+
+        while (len_ > 0)
+        {
+            struct iovec iov[3];
+            int iov_cnt = 0;
+            auto first_len = std::min(len_, buf_sz_ - start_);
+            iov[iov_cnt].iov_base = buf_ + start_;
+            iov[iov_cnt].iov_len = static_cast<size_t>(first_len);
+            ++ iov_cnt;
+            if (len_ > first_len)
+            {
+                //回绕的后半段
+                iov[iov_cnt].iov_base = buf_;
+                iov[iov_cnt].iov_len = static_cast<size_t>(len_ - first_len);
+                ++ iov_cnt;
+            }
+            iov[iov_cnt].iov_base = const_cast<char *>(buf);
+            iov[iov_cnt].iov_len = static_cast<size_t>(sz);
+            ++ iov_cnt;
+
+            auto ret = do_writev_(iov, iov_cnt);
+            LOM_SDT_PROBE2(buf_writer_flush, len_ + sz, ret);
+            if (ret < 0)
+            {
+                return static_cast<int>(ret);
+            }
+            Assert(ret > 0 && ret <= len_ + sz);
+            if (ret < len_)
+            {
+                Consume(ret);
+                continue;
+            }
+            ret -= len_;
+            Consume(len_);
+            buf += ret;
+            sz -= ret;
+        }
+
+        while (sz > 0)
+        {
+            auto ret = do_write_(buf, sz);
+            LOM_SDT_PROBE2(buf_writer_flush, sz, ret);
+            if (ret < 0)
+            {
+                return static_cast<int>(ret);
+            }
+            Assert(ret > 0 && ret <= sz);
+            buf += ret;
+            sz -= ret;
+        }
+
+        return 0;
+    }
+
 public:
 
-    BufWriterImpl(BufWriter::DoWriteFunc do_write, ssize_t buf_sz) :
-        do_write_(do_write), buf_sz_(AdjustBufSize(buf_sz)), buf_(new char[buf_sz_])
+    BufWriterImpl(BufWriter::DoWriteFunc do_write, ssize_t buf_sz, BufWriter::DoWriteVFunc do_writev) :
+        do_write_(do_write), do_writev_(do_writev), buf_sz_(AdjustBufSize(buf_sz)), buf_(new char[buf_sz_])
     {
     }
 
@@ -190,6 +482,11 @@ public:
             return -1;
         }
 
+        if (sz >= buf_sz_)
+        {
+            return WriteDirect(buf, sz);
+        }
+
         while (sz > 0)
         {
             Assert(len_ <= buf_sz_);
@@ -239,9 +536,9 @@ public:
     }
 };
 
-BufWriter::Ptr BufWriter::New(BufWriter::DoWriteFunc do_write, ssize_t buf_sz)
+BufWriter::Ptr BufWriter::New(BufWriter::DoWriteFunc do_write, ssize_t buf_sz, BufWriter::DoWriteVFunc do_writev)
 {
-    return BufWriter::Ptr(new BufWriterImpl(do_write, buf_sz));
+    return BufWriter::Ptr(new BufWriterImpl(do_write, buf_sz, do_writev));
 }
 
 }
@@ -0,0 +1,309 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace io
+{
+
+/*
+内存池的块在线程本地的空闲链表中缓存，空闲块的开头用作链表指针
+块可能在创建它以外的线程中释放，此时进入释放线程的链表，不影响正确性
+*/
+static const ssize_t kFreeBlockCountMax = 256;
+
+static thread_local char *free_blocks = nullptr;
+static thread_local ssize_t free_block_count = 0;
+
+static char *AllocBlock()
+{
+    if (free_blocks == nullptr)
+    {
+        return new char[ChainBuf::kBlockSize];
+    }
+    char *blk = free_blocks;
+    memcpy(&free_blocks, blk, sizeof(free_blocks));
+    -- free_block_count;
+    return blk;
+}
+
+static void FreeBlock(const char *p)
+{
+    char *blk = const_cast<char *>(p);
+    if (free_block_count >= kFreeBlockCountMax)
+    {
+        delete[] blk;
+        return;
+    }
+    memcpy(blk, &free_blocks, sizeof(free_blocks));
+    free_blocks = blk;
+    ++ free_block_count;
+}
+
+ChainBuf::Seg &ChainBuf::TailSpace()
+{
+    if (segs_.empty() || segs_.back().avail_ == 0)
+    {
+        Seg seg;
+        seg.p_ = std::shared_ptr<const char>(AllocBlock(), FreeBlock);
+        seg.len_ = 0;
+        seg.avail_ = kBlockSize;
+        segs_.emplace_back(std::move(seg));
+    }
+    return segs_.back();
+}
+
+void ChainBuf::PopFront(ssize_t n, ChainBuf *out)
+{
+    Assert(0 <= n && n <= len_);
+    len_ -= n;
+    while (n > 0)
+    {
+        Seg &seg = segs_.front();
+        if (seg.len_ <= n)
+        {
+            n -= seg.len_;
+            if (out != nullptr)
+            {
+                out->len_ += seg.len_;
+                out->segs_.emplace_back(std::move(seg));
+            }
+            segs_.pop_front();
+            continue;
+        }
+
+        //拆分段，前半部分不可追加写入，后半部分保留原来的可写空间
+        if (out != nullptr)
+        {
+            Seg front_seg;
+            front_seg.p_ = seg.p_;
+            front_seg.len_ = n;
+            front_seg.avail_ = 0;
+            out->len_ += n;
+            out->segs_.emplace_back(std::move(front_seg));
+        }
+        seg.p_ = std::shared_ptr<const char>(seg.p_, seg.p_.get() + n);
+        seg.len_ -= n;
+        n = 0;
+    }
+    //空的段（如只有可写空间的尾部块）留在链中没有意义，但也无害，只在全部移除时清理
+    if (len_ == 0)
+    {
+        segs_.clear();
+    }
+}
+
+void ChainBuf::Append(StrSlice s)
+{
+    const char *p = s.Data();
+    ssize_t sz = s.Len();
+    while (sz > 0)
+    {
+        Seg &seg = TailSpace();
+        ssize_t copy_len = std::min(sz, seg.avail_);
+        memcpy(const_cast<char *>(seg.p_.get()) + seg.len_, p, copy_len);
+        seg.len_ += copy_len;
+        seg.avail_ -= copy_len;
+        len_ += copy_len;
+        p += copy_len;
+        sz -= copy_len;
+    }
+}
+
+void ChainBuf::Append(Str s)
+{
+    if (s.Len() < kAdoptLenMin)
+    {
+        Append(s.Slice());
+        return;
+    }
+
+    //通过shared_ptr的别名构造，使段指向Str的数据并持有Str本身
+    auto holder = std::make_shared<Str>(std::move(s));
+    Seg seg;
+    seg.p_ = std::shared_ptr<const char>(holder, holder->Data());
+    seg.len_ = holder->Len();
+    seg.avail_ = 0;
+    len_ += seg.len_;
+    segs_.emplace_back(std::move(seg));
+}
+
+void ChainBuf::Append(ChainBuf &&other)
+{
+    if (this == &other)
+    {
+        return;
+    }
+    for (auto &seg : other.segs_)
+    {
+        segs_.emplace_back(std::move(seg));
+    }
+    len_ += other.len_;
+    other.Clear();
+}
+
+void ChainBuf::Prepend(StrSlice s)
+{
+    ChainBuf cb;
+    cb.Append(s);
+    Prepend(std::move(cb));
+}
+
+void ChainBuf::Prepend(Str s)
+{
+    ChainBuf cb;
+    cb.Append(std::move(s));
+    Prepend(std::move(cb));
+}
+
+void ChainBuf::Prepend(ChainBuf &&other)
+{
+    if (this == &other)
+    {
+        return;
+    }
+    if (!other.segs_.empty())
+    {
+        //other的尾部段之后是本对象的数据，不能再追加写入
+        other.segs_.back().avail_ = 0;
+    }
+    for (auto iter = other.segs_.rbegin(); iter != other.segs_.rend(); ++ iter)
+    {
+        segs_.emplace_front(std::move(*iter));
+    }
+    len_ += other.len_;
+    other.Clear();
+}
+
+ChainBuf ChainBuf::Split(ssize_t n)
+{
+    ChainBuf out;
+    PopFront(n, &out);
+    return out;
+}
+
+void ChainBuf::Discard(ssize_t n)
+{
+    PopFront(n, nullptr);
+}
+
+StrSlice ChainBuf::Coalesce(ssize_t n)
+{
+    Assert(0 <= n && n <= len_);
+    if (n == 0)
+    {
+        return StrSlice();
+    }
+    if (segs_.front().len_ >= n)
+    {
+        return StrSlice(segs_.front().p_.get(), n);
+    }
+
+    Seg seg;
+    if (n <= kBlockSize)
+    {
+        seg.p_ = std::shared_ptr<const char>(AllocBlock(), FreeBlock);
+    }
+    else
+    {
+        seg.p_ = std::shared_ptr<const char>(new char[n], std::default_delete<const char []>());
+    }
+    seg.len_ = n;
+    seg.avail_ = 0;
+
+    char *p = const_cast<char *>(seg.p_.get());
+    ssize_t done = 0;
+    for (auto const &s : segs_)
+    {
+        if (done == n)
+        {
+            break;
+        }
+        ssize_t copy_len = std::min(s.len_, n - done);
+        memcpy(p + done, s.p_.get(), copy_len);
+        done += copy_len;
+    }
+    PopFront(n, nullptr);
+    segs_.emplace_front(std::move(seg));
+    len_ += n;
+    return StrSlice(p, n);
+}
+
+Str ChainBuf::ToStr() const
+{
+    Str::Buf buf(0, len_);
+    for (auto const &seg : segs_)
+    {
+        buf.Append(seg.p_.get(), seg.len_);
+    }
+    return Str(std::move(buf));
+}
+
+int ChainBuf::FillIovecs(struct iovec *iov, int iov_cnt_max) const
+{
+    int iov_cnt = 0;
+    for (auto const &seg : segs_)
+    {
+        if (iov_cnt >= iov_cnt_max)
+        {
+            break;
+        }
+        if (seg.len_ == 0)
+        {
+            continue;
+        }
+        iov[iov_cnt].iov_base = const_cast<char *>(seg.p_.get());
+        iov[iov_cnt].iov_len = static_cast<size_t>(seg.len_);
+        ++ iov_cnt;
+    }
+    return iov_cnt;
+}
+
+ssize_t ChainBuf::ReadFrom(const BufReader::DoReadFunc &do_read)
+{
+    Seg &seg = TailSpace();
+    ssize_t ret = do_read(const_cast<char *>(seg.p_.get()) + seg.len_, seg.avail_);
+    if (ret > 0)
+    {
+        Assert(ret <= seg.avail_);
+        seg.len_ += ret;
+        seg.avail_ -= ret;
+        len_ += ret;
+    }
+    return ret;
+}
+
+ssize_t ChainBuf::WriteTo(const BufWriter::DoWriteVFunc &do_writev)
+{
+    struct iovec iov[kIovCountMax];
+    int iov_cnt = FillIovecs(iov, kIovCountMax);
+    if (iov_cnt == 0)
+    {
+        return 0;
+    }
+    ssize_t ret = do_writev(iov, iov_cnt);
+    if (ret > 0)
+    {
+        Assert(ret <= len_);
+        Discard(ret);
+    }
+    return ret;
+}
+
+int ChainBuf::WriteAllTo(const BufWriter::DoWriteVFunc &do_writev)
+{
+    while (len_ > 0)
+    {
+        ssize_t ret = WriteTo(do_writev);
+        if (ret < 0)
+        {
+            return static_cast<int>(ret);
+        }
+        Assert(ret > 0);
+    }
+    return 0;
+}
+
+}
+
+}
@@ -0,0 +1,338 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace io
+{
+
+static void AssertValidFrameOptions(const FrameOptions &opts)
+{
+    switch (opts.kind_)
+    {
+        case FrameOptions::kLenPrefix:
+        {
+            Assert(opts.len_prefix_sz_ == 1 || opts.len_prefix_sz_ == 2 || opts.len_prefix_sz_ == 4 || opts.len_prefix_sz_ == 8);
+            break;
+        }
+        case FrameOptions::kVarIntLenPrefix:
+        {
+            break;
+        }
+        case FrameOptions::kDelim:
+        {
+            Assert(opts.delim_.Len() > 0);
+            break;
+        }
+        default:
+        {
+            Die(Sprintf("invalid frame kind [%d]", static_cast<int>(opts.kind_)));
+        }
+    }
+    Assert(opts.frame_len_max_ >= 0);
+}
+
+#define LOM_IO_FRAME_ERR(_errno, _msg) do {    \
+        SetErr(_msg);                           \
+        errno = _errno;                         \
+        return -1;                              \
+    } while (false)
+
+class FrameReaderImpl : public FrameReader
+{
+    BufReader::Ptr br_;
+    FrameOptions opts_;
+
+    //上次返回的帧在缓冲中占用的长度，为保证返回的视图有效，推迟到下次调用时再消耗
+    ssize_t consumed_len_ = 0;
+
+    /*
+    解析data头部的一帧，成功时设置frame并返回这一帧的总长度（含长度前缀或分隔符）
+    数据不完整返回0，并将need_len设置为至少需要的数据长度，出错返回-1
+    scanned_len为kDelim格式已查找过的长度，避免数据逐步增加时重复查找
+    */
+    ssize_t ParseFrame(StrSlice data, StrSlice &frame, ssize_t &need_len, ssize_t &scanned_len) const
+    {
+        uint64_t frame_len = 0;
+        ssize_t hdr_len = 0;
+        switch (opts_.kind_)
+        {
+            case FrameOptions::kLenPrefix:
+            {
+                hdr_len = opts_.len_prefix_sz_;
+                if (data.Len() < hdr_len)
+                {
+                    need_len = hdr_len;
+                    return 0;
+                }
+                for (ssize_t i = 0; i < hdr_len; ++ i)
+                {
+                    frame_len = (frame_len << 8) | static_cast<uint8_t>(data.Data()[i]);
+                }
+                break;
+            }
+            case FrameOptions::kVarIntLenPrefix:
+            {
+                if (data.Len() == 0)
+                {
+                    need_len = 1;
+                    return 0;
+                }
+                hdr_len = var_int::EncodedLen(data.Data()[0]);
+                if (hdr_len < 0)
+                {
+                    LOM_IO_FRAME_ERR(EBADMSG, "invalid var_int frame len");
+                }
+                if (data.Len() < hdr_len)
+                {
+                    need_len = hdr_len;
+                    return 0;
+                }
+                const char *p = data.Data();
+                ssize_t sz = hdr_len;
+                if (!var_int::DecodeUInt(p, sz, frame_len))
+                {
+                    LOM_IO_FRAME_ERR(EBADMSG, "invalid var_int frame len");
+                }
+                break;
+            }
+            case FrameOptions::kDelim:
+            {
+                StrSlice delim = opts_.delim_.Slice();
+                auto scan_from = std::max<ssize_t>(scanned_len - (delim.Len() - 1), 0);
+                auto p = static_cast<const char *>(memmem(
+                    data.Data() + scan_from, static_cast<size_t>(data.Len() - scan_from),
+                    delim.Data(), static_cast<size_t>(delim.Len())));
+                if (p == nullptr)
+                {
+                    if (data.Len() - (delim.Len() - 1) > opts_.frame_len_max_)
+                    {
+                        LOM_IO_FRAME_ERR(EMSGSIZE, "frame too long");
+                    }
+                    scanned_len = data.Len();
+                    need_len = data.Len() + 1;
+                    return 0;
+                }
+                frame_len = static_cast<uint64_t>(p - data.Data());
+                if (frame_len > static_cast<uint64_t>(opts_.frame_len_max_))
+                {
+                    LOM_IO_FRAME_ERR(EMSGSIZE, "frame too long");
+                }
+                frame = data.Slice(0, static_cast<ssize_t>(frame_len));
+                return static_cast<ssize_t>(frame_len) + delim.Len();
+            }
+            default:
+            {
+                Die("unreachable");
+            }
+        }
+
+        if (frame_len > static_cast<uint64_t>(opts_.frame_len_max_))
+        {
+            LOM_IO_FRAME_ERR(EMSGSIZE, "frame too long");
+        }
+        ssize_t total_len = hdr_len + static_cast<ssize_t>(frame_len);
+        if (data.Len() < total_len)
+        {
+            need_len = total_len;
+            return 0;
+        }
+        frame = data.Slice(hdr_len, static_cast<ssize_t>(frame_len));
+        return total_len;
+    }
+
+    //消耗上次返回的帧，这部分数据已在缓冲中，不会调用下层读函数
+    int DiscardConsumed()
+    {
+        if (consumed_len_ > 0)
+        {
+            auto ret = br_->Discard(consumed_len_);
+            if (ret < 0)
+            {
+                return static_cast<int>(ret);
+            }
+            Assert(ret == consumed_len_);
+            consumed_len_ = 0;
+        }
+        return 0;
+    }
+
+    /*
+    读到第一个完整的帧，成功时返回1，同时data被设置为缓冲中全部数据的视图，consumed_len_为第一帧的长度
+    只在缓冲中的数据不足一帧时才调用下层读函数
+    */
+    ssize_t ReadFirst(StrSlice &data, StrSlice &frame)
+    {
+        int err = DiscardConsumed();
+        if (err < 0)
+        {
+            return err;
+        }
+
+        ssize_t want_len = 1, scanned_len = 0;
+        for (;;)
+        {
+            want_len = std::max(want_len, br_->Buffered());
+            auto ret = br_->Peek(want_len, data);
+            if (ret < 0)
+            {
+                return ret;
+            }
+
+            ssize_t need_len = 0;
+            auto frame_len = ParseFrame(data, frame, need_len, scanned_len);
+            if (frame_len < 0)
+            {
+                return frame_len;
+            }
+            if (frame_len > 0)
+            {
+                consumed_len_ = frame_len;
+                break;
+            }
+            if (ret < want_len)
+            {
+                //EOF
+                if (ret == 0)
+                {
+                    return 0;
+                }
+                LOM_IO_FRAME_ERR(EBADMSG, "incomplete frame at EOF");
+            }
+            want_len = std::max(need_len, want_len + 1);
+        }
+
+        //Peek期间可能读入了更多数据，取全部已缓冲数据的视图，不会调用下层读函数，也不会移动数据
+        auto ret = br_->Peek(br_->Buffered(), data);
+        Assert(ret == br_->Buffered() && ret >= consumed_len_);
+        return 1;
+    }
+
+public:
+
+    FrameReaderImpl(BufReader::Ptr br, const FrameOptions &opts) : br_(br), opts_(opts)
+    {
+    }
+
+    virtual ssize_t Read(StrSlice &frame) override
+    {
+        StrSlice data;
+        return ReadFirst(data, frame);
+    }
+
+    virtual ssize_t ReadBatch(const OnFrameFunc &on_frame) override
+    {
+        StrSlice data, frame;
+        auto ret = ReadFirst(data, frame);
+        if (ret <= 0)
+        {
+            return ret;
+        }
+        on_frame(frame);
+
+        //剩余的不完整的帧或格式错误留到下次调用时处理
+        ssize_t frame_count = 1;
+        for (;;)
+        {
+            ssize_t need_len = 0, scanned_len = 0;
+            auto frame_len = ParseFrame(data.Slice(consumed_len_), frame, need_len, scanned_len);
+            if (frame_len <= 0)
+            {
+                break;
+            }
+            consumed_len_ += frame_len;
+            on_frame(frame);
+            ++ frame_count;
+        }
+        return frame_count;
+    }
+};
+
+FrameReader::Ptr FrameReader::New(BufReader::Ptr br, const FrameOptions &opts)
+{
+    AssertValidFrameOptions(opts);
+    return FrameReader::Ptr(new FrameReaderImpl(br, opts));
+}
+
+class FrameWriterImpl : public FrameWriter
+{
+    BufWriter::Ptr bw_;
+    FrameOptions opts_;
+
+public:
+
+    FrameWriterImpl(BufWriter::Ptr bw, const FrameOptions &opts) : bw_(bw), opts_(opts)
+    {
+    }
+
+    virtual int Write(StrSlice frame) override
+    {
+        auto frame_len = frame.Len();
+        if (frame_len > opts_.frame_len_max_)
+        {
+            LOM_IO_FRAME_ERR(EMSGSIZE, "frame too long");
+        }
+
+        int ret = 0;
+        switch (opts_.kind_)
+        {
+            case FrameOptions::kLenPrefix:
+            {
+                auto sz = opts_.len_prefix_sz_;
+                if (sz < 8 && static_cast<uint64_t>(frame_len) >> (sz * 8) != 0)
+                {
+                    LOM_IO_FRAME_ERR(EMSGSIZE, "frame too long for len prefix");
+                }
+                char hdr[8];
+                for (ssize_t i = sz - 1; i >= 0; -- i)
+                {
+                    hdr[i] = static_cast<char>(frame_len & 0xFF);
+                    frame_len >>= 8;
+                }
+                ret = bw_->WriteAll(hdr, sz);
+                break;
+            }
+            case FrameOptions::kVarIntLenPrefix:
+            {
+                auto hdr = var_int::EncodeUInt(static_cast<uint64_t>(frame_len));
+                ret = bw_->WriteAll(hdr.Data(), hdr.Len());
+                break;
+            }
+            case FrameOptions::kDelim:
+            {
+                ret = bw_->WriteAll(frame.Data(), frame.Len());
+                if (ret == 0)
+                {
+                    ret = bw_->WriteAll(opts_.delim_.Data(), opts_.delim_.Len());
+                }
+                return ret;
+            }
+            default:
+            {
+                Die("unreachable");
+            }
+        }
+        if (ret == 0)
+        {
+            ret = bw_->WriteAll(frame.Data(), frame.Len());
+        }
+        return ret;
+    }
+
+    virtual int Flush() override
+    {
+        return bw_->Flush();
+    }
+};
+
+#undef LOM_IO_FRAME_ERR
+
+FrameWriter::Ptr FrameWriter::New(BufWriter::Ptr bw, const FrameOptions &opts)
+{
+    AssertValidFrameOptions(opts);
+    return FrameWriter::Ptr(new FrameWriterImpl(bw, opts));
+}
+
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../internal.h"
+
+namespace lom
+{
+
+namespace io
+{
+
+//设置错误信息，errno不为0时在其后附加errno，并保持errno不变，用于系统调用失败的情况
+void SetSysCallErr(const Str &s, CodePos _cp = CodePos());
+
+}
+
+}
+
+//BufReader系列接口的参数检查，不合法时设置错误信息和errno并返回-1
+#define LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(_sz) do {  \
+        if (_sz <= 0) {                                 \
+            SetErr("non-positive size");                \
+            errno = EINVAL;                             \
+            return -1;                                  \
+        }                                               \
+    } while (false)
+
+#define LOM_IO_CHECK_EMPTY_END_PARAM(_end) do {        \
+        if (_end.Len() == 0) {                          \
+            SetErr("empty end");                        \
+            errno = EINVAL;                             \
+            return -1;                                  \
+        }                                               \
+    } while (false)
@@ -1,4 +1,4 @@
-#include "../internal.h"
+#include "internal.h"
 
 namespace lom
 {
@@ -6,6 +6,13 @@ namespace lom
 namespace io
 {
 
+void SetSysCallErr(const Str &s, CodePos _cp)
+{
+    int save_errno = errno;
+    SetErr(save_errno == 0 ? s : s.Concat(Sprintf(" <errno=%d>", save_errno)), _cp);
+    errno = save_errno;
+}
+
 }
 
 }
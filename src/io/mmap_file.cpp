@@ -0,0 +1,310 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace io
+{
+
+static const ssize_t kHugePageSize = 2 * 1024 * 1024;
+
+/*
+以一段内存为数据的BufReader，数据全部视为已缓冲，语义同BufReader::New创建的对象
+holder_持有数据所在的映射，保证视图在本对象存在期间有效
+*/
+class MmapBufReader : public BufReader
+{
+    std::shared_ptr<const void> holder_;
+    StrSlice s_;
+
+    //消耗n字节并返回其视图
+    StrSlice Consume(ssize_t n)
+    {
+        auto s = s_.Slice(0, n);
+        s_ = s_.Slice(n);
+        return s;
+    }
+
+    //在min(sz, 剩余长度)的范围内查找end，返回需要消耗的长度（找到时包括end）
+    ssize_t UntilLen(const char *end, ssize_t end_len, ssize_t sz) const
+    {
+        auto scan_len = std::min(sz, s_.Len());
+        if (scan_len < end_len)
+        {
+            return scan_len;
+        }
+        auto p = end_len == 1 ?
+            static_cast<const char *>(memchr(s_.Data(), *end, static_cast<size_t>(scan_len))) :
+            static_cast<const char *>(memmem(s_.Data(), static_cast<size_t>(scan_len), end, static_cast<size_t>(end_len)));
+        return p == nullptr ? scan_len : p - s_.Data() + end_len;
+    }
+
+    ssize_t CopyOut(char *buf, ssize_t n)
+    {
+        memcpy(buf, s_.Data(), n);
+        s_ = s_.Slice(n);
+        return n;
+    }
+
+public:
+
+    MmapBufReader(std::shared_ptr<const void> holder, StrSlice s) : holder_(holder), s_(s)
+    {
+    }
+
+    virtual ssize_t Read(char *buf, ssize_t sz) override
+    {
+        LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(sz);
+        return CopyOut(buf, std::min(sz, s_.Len()));
+    }
+
+    virtual ssize_t ReadUntil(char end_ch, char *buf, ssize_t sz) override
+    {
+        LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(sz);
+        return CopyOut(buf, UntilLen(&end_ch, 1, sz));
+    }
+
+    virtual ssize_t ReadUntil(StrSlice end, char *buf, ssize_t sz) override
+    {
+        LOM_IO_CHECK_EMPTY_END_PARAM(end);
+        LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(sz);
+        return CopyOut(buf, UntilLen(end.Data(), end.Len(), sz));
+    }
+
+    virtual ssize_t ReadFull(char *buf, ssize_t sz) override
+    {
+        return Read(buf, sz);
+    }
+
+    virtual ssize_t Peek(ssize_t n, StrSlice &s) override
+    {
+        LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(n);
+        s = s_.Slice(0, std::min(n, s_.Len()));
+        return s.Len();
+    }
+
+    virtual ssize_t ReadSlice(char end_ch, ssize_t sz, StrSlice &s) override
+    {
+        LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(sz);
+        s = Consume(UntilLen(&end_ch, 1, sz));
+        return s.Len();
+    }
+
+    virtual ssize_t ReadSlice(StrSlice end, ssize_t sz, StrSlice &s) override
+    {
+        LOM_IO_CHECK_EMPTY_END_PARAM(end);
+        LOM_IO_CHECK_NON_POSITIVE_SIZE_PARAM(sz);
+        s = Consume(UntilLen(end.Data(), end.Len(), sz));
+        return s.Len();
+    }
+
+    virtual ssize_t Discard(ssize_t n) override
+    {
+        if (n < 0)
+        {
+            SetErr("negative size");
+            errno = EINVAL;
+            return -1;
+        }
+        return Consume(std::min(n, s_.Len())).Len();
+    }
+
+    virtual ssize_t Buffered() const override
+    {
+        return s_.Len();
+    }
+};
+
+class MmapFileImpl : public MmapFile, public std::enable_shared_from_this<MmapFileImpl>
+{
+    char *p_;
+    ssize_t len_;
+
+public:
+
+    MmapFileImpl(char *p, ssize_t len) : p_(p), len_(len)
+    {
+    }
+
+    virtual ~MmapFileImpl()
+    {
+        if (len_ > 0)
+        {
+            munmap(p_, static_cast<size_t>(len_));
+        }
+    }
+
+    virtual StrSlice Data() const override
+    {
+        return StrSlice(p_, len_);
+    }
+
+    virtual bool Advise(Advice advice, ssize_t off, ssize_t len) const override
+    {
+        Assert(0 <= off && off <= len_);
+        if (len < 0 || len > len_ - off)
+        {
+            len = len_ - off;
+        }
+        if (len == 0)
+        {
+            return true;
+        }
+
+        int adv;
+        switch (advice)
+        {
+            case kNormal:
+            {
+                adv = MADV_NORMAL;
+                break;
+            }
+            case kSequential:
+            {
+                adv = MADV_SEQUENTIAL;
+                break;
+            }
+            case kRandom:
+            {
+                adv = MADV_RANDOM;
+                break;
+            }
+            case kWillNeed:
+            {
+                adv = MADV_WILLNEED;
+                break;
+            }
+            case kDontNeed:
+            {
+                adv = MADV_DONTNEED;
+                break;
+            }
+            case kHugePage:
+            {
+                adv = MADV_HUGEPAGE;
+                break;
+            }
+            default:
+            {
+                SetErr(Sprintf("invalid advice [%d]", static_cast<int>(advice)));
+                errno = EINVAL;
+                return false;
+            }
+        }
+
+        //madvise要求起始地址页对齐，映射的起始地址是页对齐的，因此只需将off向下对齐
+        static const ssize_t page_sz = sysconf(_SC_PAGESIZE);
+        ssize_t start = off / page_sz * page_sz;
+        if (madvise(p_ + start, static_cast<size_t>(off + len - start), adv) == -1)
+        {
+            SetSysCallErr("madvise failed");
+            return false;
+        }
+        return true;
+    }
+
+    virtual BufReader::Ptr NewBufReader(ssize_t off, ssize_t len) const override
+    {
+        auto self = std::const_pointer_cast<MmapFileImpl>(shared_from_this());
+        return BufReader::Ptr(new MmapBufReader(self, Range(off, len)));
+    }
+};
+
+/*
+映射fd的前len字节，len不小于大页大小时，先保留多出一个大页的地址空间，再将文件映射到其中按大页对齐的位置，
+最后释放两端多余的部分
+*/
+static char *MapFile(int fd, ssize_t len, bool populate)
+{
+    int flags = MAP_SHARED | (populate ? MAP_POPULATE : 0);
+    if (len < kHugePageSize)
+    {
+        auto p = mmap(nullptr, static_cast<size_t>(len), PROT_READ, flags, fd, 0);
+        return p == MAP_FAILED ? nullptr : static_cast<char *>(p);
+    }
+
+    ssize_t reserve_len = len + kHugePageSize;
+    auto reserved = mmap(nullptr, static_cast<size_t>(reserve_len), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserved == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    auto reserved_start = static_cast<char *>(reserved), reserved_end = reserved_start + reserve_len;
+    auto aligned = reinterpret_cast<char *>(
+        (reinterpret_cast<uintptr_t>(reserved_start) + kHugePageSize - 1) & ~static_cast<uintptr_t>(kHugePageSize - 1));
+    auto p = mmap(aligned, static_cast<size_t>(len), PROT_READ, flags | MAP_FIXED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        int save_errno = errno;
+        munmap(reserved, static_cast<size_t>(reserve_len));
+        errno = save_errno;
+        return nullptr;
+    }
+
+    //文件映射的末尾按页对齐后才是保留区剩余部分的开始
+    static const ssize_t page_sz = sysconf(_SC_PAGESIZE);
+    auto map_end = aligned + (len + page_sz - 1) / page_sz * page_sz;
+    if (aligned > reserved_start)
+    {
+        munmap(reserved_start, static_cast<size_t>(aligned - reserved_start));
+    }
+    if (reserved_end > map_end)
+    {
+        munmap(map_end, static_cast<size_t>(reserved_end - map_end));
+    }
+    return aligned;
+}
+
+MmapFile::Ptr MmapFile::Open(const char *path, bool populate)
+{
+    int fd;
+    do
+    {
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    } while (fd == -1 && errno == EINTR);
+    if (fd == -1)
+    {
+        SetSysCallErr("open file failed");
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        SetSysCallErr("fstat failed");
+        int save_errno = errno;
+        close(fd);
+        errno = save_errno;
+        return nullptr;
+    }
+    if (!S_ISREG(st.st_mode))
+    {
+        close(fd);
+        SetErr("not a regular file");
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    auto len = static_cast<ssize_t>(st.st_size);
+    char *p = nullptr;
+    if (len > 0)
+    {
+        p = MapFile(fd, len, populate);
+        if (p == nullptr)
+        {
+            SetSysCallErr("mmap failed");
+            int save_errno = errno;
+            close(fd);
+            errno = save_errno;
+            return nullptr;
+        }
+    }
+
+    //映射建立后不再需要fd
+    close(fd);
+    return std::make_shared<MmapFileImpl>(p, len);
+}
+
+}
+
+}
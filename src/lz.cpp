@@ -0,0 +1,651 @@
+#include "internal.h"
+
+namespace lom
+{
+
+namespace lz
+{
+
+static const ssize_t
+    kMatchLenMin        = 4,
+    kLastLiteralLen     = 5,    //块的最后若干字节总是作为字面量，使匹配的比较可以按8字节进行而不越界
+    kMatchStartLimit    = 12,   //块末尾这个长度内不再开始查找匹配
+    kOffsetMax          = 65535,
+    kDefaultBlockSize   = 64 * 1024,
+    kBlockHdrLenMax     = 18;   //两个var_int
+
+static const int kHashBits = 14;
+
+/*
+哈希表记录最近出现的4字节串在块中的位置，不需要每块清空：
+残留的旧位置只是一个错误的候选，会被位置和内容的检查过滤掉
+*/
+static thread_local uint32_t hash_table[1 << kHashBits];
+
+static uint32_t Load32(const char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t Load64(const char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t Hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - kHashBits);
+}
+
+//返回p和match开始的相同字节数，p不超过p_limit
+static ssize_t CountCommon(const char *p, const char *match, const char *p_limit)
+{
+    const char *start = p;
+    while (p + 8 <= p_limit)
+    {
+        uint64_t diff = Load64(p) ^ Load64(match);
+        if (diff != 0)
+        {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return p - start + (__builtin_ctzll(diff) >> 3);
+#else
+            return p - start + (__builtin_clzll(diff) >> 3);
+#endif
+        }
+        p += 8;
+        match += 8;
+    }
+    while (p < p_limit && *p == *match)
+    {
+        ++ p;
+        ++ match;
+    }
+    return p - start;
+}
+
+static char *WriteExtLen(char *op, ssize_t len)
+{
+    while (len >= 255)
+    {
+        *op ++ = static_cast<char>(255);
+        len -= 255;
+    }
+    *op ++ = static_cast<char>(len);
+    return op;
+}
+
+//输出一个序列，match_len为0表示最后一个只有字面量的序列
+static char *WriteSeq(char *op, const char *literal, ssize_t literal_len, ssize_t offset, ssize_t match_len)
+{
+    char *token = op ++;
+    uint8_t tk;
+    if (literal_len >= 15)
+    {
+        tk = 15 << 4;
+        op = WriteExtLen(op, literal_len - 15);
+    }
+    else
+    {
+        tk = static_cast<uint8_t>(literal_len << 4);
+    }
+    memcpy(op, literal, literal_len);
+    op += literal_len;
+
+    if (match_len > 0)
+    {
+        *op ++ = static_cast<char>(offset & 0xFF);
+        *op ++ = static_cast<char>(offset >> 8);
+        ssize_t ml = match_len - kMatchLenMin;
+        if (ml >= 15)
+        {
+            tk |= 15;
+            op = WriteExtLen(op, ml - 15);
+        }
+        else
+        {
+            tk |= static_cast<uint8_t>(ml);
+        }
+    }
+    *token = static_cast<char>(tk);
+    return op;
+}
+
+ssize_t CompressBlock(const char *src, ssize_t src_len, char *dst)
+{
+    Assert(0 <= src_len && src_len <= kBlockSizeMax);
+
+    const char *ip = src, *anchor = src, *end = src + src_len;
+    char *op = dst;
+
+    if (src_len > kMatchStartLimit)
+    {
+        const char *match_start_limit = end - kMatchStartLimit, *match_limit = end - kLastLiteralLen;
+        while (ip <= match_start_limit)
+        {
+            uint32_t v = Load32(ip);
+            uint32_t h = Hash(v);
+            ssize_t pos = ip - src, match_pos = hash_table[h];
+            hash_table[h] = static_cast<uint32_t>(pos);
+            if (match_pos >= pos || pos - match_pos > kOffsetMax || Load32(src + match_pos) != v)
+            {
+                //连续找不到匹配时加大步长，快速跳过不可压缩的数据
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            //向前扩展匹配
+            const char *match = src + match_pos;
+            while (ip > anchor && match > src && ip[-1] == match[-1])
+            {
+                -- ip;
+                -- match;
+            }
+            ssize_t match_len = kMatchLenMin + CountCommon(ip + kMatchLenMin, match + kMatchLenMin, match_limit);
+            op = WriteSeq(op, anchor, ip - anchor, ip - match, match_len);
+            ip += match_len;
+            anchor = ip;
+
+            if (ip <= match_start_limit)
+            {
+                //补充匹配末尾附近的位置，提高后续匹配的命中率
+                hash_table[Hash(Load32(ip - 2))] = static_cast<uint32_t>(ip - 2 - src);
+            }
+        }
+    }
+
+    op = WriteSeq(op, anchor, end - anchor, 0, 0);
+    Assert(op - dst <= CompressBound(src_len));
+    return op - dst;
+}
+
+//读取扩展长度，出错返回false
+static bool ReadExtLen(const uint8_t *&ip, const uint8_t *ip_end, ssize_t &len)
+{
+    for (;;)
+    {
+        if (ip >= ip_end)
+        {
+            return false;
+        }
+        uint8_t b = *ip ++;
+        len += b;
+        if (len > kBlockSizeMax)
+        {
+            return false;
+        }
+        if (b != 255)
+        {
+            return true;
+        }
+    }
+}
+
+ssize_t DecompressBlock(const char *src, ssize_t src_len, char *dst, ssize_t dst_cap)
+{
+    auto ip = reinterpret_cast<const uint8_t *>(src);
+    auto ip_end = ip + src_len;
+    char *op = dst, *op_end = dst + dst_cap;
+
+    for (;;)
+    {
+        if (ip >= ip_end)
+        {
+            return -1;
+        }
+        uint8_t tk = *ip ++;
+
+        ssize_t literal_len = tk >> 4;
+        if (literal_len == 15 && !ReadExtLen(ip, ip_end, literal_len))
+        {
+            return -1;
+        }
+        if (literal_len > ip_end - ip || literal_len > op_end - op)
+        {
+            return -1;
+        }
+        //短数据在两边空间都足够时按固定的16字节拷贝，多拷贝的部分会被后续的输出覆盖
+        if (literal_len <= 16 && ip_end - ip >= 16 && op_end - op >= 16)
+        {
+            memcpy(op, ip, 16);
+        }
+        else
+        {
+            memcpy(op, ip, literal_len);
+        }
+        ip += literal_len;
+        op += literal_len;
+
+        if (ip == ip_end)
+        {
+            //最后一个序列
+            break;
+        }
+
+        if (ip_end - ip < 2)
+        {
+            return -1;
+        }
+        ssize_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - dst)
+        {
+            return -1;
+        }
+        ssize_t match_len = tk & 15;
+        if (match_len == 15 && !ReadExtLen(ip, ip_end, match_len))
+        {
+            return -1;
+        }
+        match_len += kMatchLenMin;
+        if (match_len > op_end - op)
+        {
+            return -1;
+        }
+
+        const char *match = op - offset;
+        if (offset >= 16 && match_len <= 16 && op_end - op >= 16)
+        {
+            memcpy(op, match, 16);
+            op += match_len;
+        }
+        else if (offset >= match_len)
+        {
+            memcpy(op, match, match_len);
+            op += match_len;
+        }
+        else
+        {
+            //重叠的匹配（如连续重复的短模式），数据以offset为周期，每次拷贝已输出的部分，长度逐次翻倍
+            char *match_end = op + match_len;
+            while (op < match_end)
+            {
+                ssize_t copy_len = std::min(op - match, match_end - op);
+                memcpy(op, match, copy_len);
+                op += copy_len;
+            }
+        }
+    }
+
+    return op - dst;
+}
+
+/*
+压缩一块并以流格式追加到out，压缩结果不变短时直接存储原始数据
+压缩结果先放在线程本地的临时缓冲中
+*/
+static void AppendBlock(Str::Buf &out, const char *src, ssize_t src_len)
+{
+    static thread_local std::vector<char> tmp;
+    tmp.resize(static_cast<size_t>(CompressBound(src_len)));
+    ssize_t comp_len = CompressBlock(src, src_len, tmp.data());
+
+    out.Append(var_int::EncodeUInt(static_cast<uint64_t>(src_len)).Slice());
+    if (comp_len >= src_len)
+    {
+        out.Append(var_int::EncodeUInt(0).Slice());
+        out.Append(src, src_len);
+    }
+    else
+    {
+        out.Append(var_int::EncodeUInt(static_cast<uint64_t>(comp_len)).Slice());
+        out.Append(tmp.data(), comp_len);
+    }
+}
+
+//解析块头部，成功时p和sz跳过头部，数据不足或格式错误时返回false
+static bool ParseBlockHdr(const char *&p, ssize_t &sz, ssize_t &raw_len, ssize_t &comp_len)
+{
+    const char *tmp_p = p;
+    ssize_t tmp_sz = sz;
+    uint64_t n1, n2;
+    if (!var_int::DecodeUInt(tmp_p, tmp_sz, n1) || !var_int::DecodeUInt(tmp_p, tmp_sz, n2) ||
+        n1 == 0 || n1 > static_cast<uint64_t>(kBlockSizeMax) || n2 >= n1)
+    {
+        return false;
+    }
+    raw_len = static_cast<ssize_t>(n1);
+    comp_len = static_cast<ssize_t>(n2);
+    p = tmp_p;
+    sz = tmp_sz;
+    return true;
+}
+
+//将一块的数据解压到dst（空间为raw_len），成功返回true
+static bool DecodeBlockData(const char *data, ssize_t raw_len, ssize_t comp_len, char *dst)
+{
+    if (comp_len == 0)
+    {
+        memcpy(dst, data, raw_len);
+        return true;
+    }
+    return DecompressBlock(data, comp_len, dst, raw_len) == raw_len;
+}
+
+static ssize_t BlockDataLen(ssize_t raw_len, ssize_t comp_len)
+{
+    return comp_len == 0 ? raw_len : comp_len;
+}
+
+Str Compress(StrSlice s)
+{
+    Str::Buf out(0, CompressBound(std::min(s.Len(), kDefaultBlockSize)) + kBlockHdrLenMax);
+    for (ssize_t i = 0; i < s.Len(); i += kDefaultBlockSize)
+    {
+        AppendBlock(out, s.Data() + i, std::min(kDefaultBlockSize, s.Len() - i));
+    }
+    return Str(std::move(out));
+}
+
+bool Decompress(StrSlice s, Str &out)
+{
+    //先扫描一遍块头部得到总长度，再直接解压到结果中
+    ssize_t total_len = 0;
+    const char *p = s.Data();
+    ssize_t sz = s.Len();
+    while (sz > 0)
+    {
+        ssize_t raw_len, comp_len;
+        if (!ParseBlockHdr(p, sz, raw_len, comp_len))
+        {
+            SetErr(Sprintf("invalid block header at offset [%zd]", p - s.Data()));
+            return false;
+        }
+        ssize_t data_len = BlockDataLen(raw_len, comp_len);
+        if (data_len > sz || raw_len > kStrLenMax - total_len)
+        {
+            SetErr(Sprintf("truncated or too long data at offset [%zd]", p - s.Data()));
+            return false;
+        }
+        p += data_len;
+        sz -= data_len;
+        total_len += raw_len;
+    }
+
+    Str::Buf buf(total_len);
+    p = s.Data();
+    sz = s.Len();
+    ssize_t done = 0;
+    while (sz > 0)
+    {
+        ssize_t raw_len, comp_len;
+        bool ok = ParseBlockHdr(p, sz, raw_len, comp_len);
+        Assert(ok);
+        if (!DecodeBlockData(p, raw_len, comp_len, buf.Data() + done))
+        {
+            SetErr(Sprintf("corrupted block data at offset [%zd]", p - s.Data()));
+            return false;
+        }
+        ssize_t data_len = BlockDataLen(raw_len, comp_len);
+        p += data_len;
+        sz -= data_len;
+        done += raw_len;
+    }
+    Assert(done == total_len);
+    out = std::move(buf);
+    return true;
+}
+
+class CompressWriter : public io::BufWriter
+{
+    io::BufWriter::Ptr bw_;
+    ssize_t block_sz_;
+    char *buf_;
+    ssize_t len_ = 0;
+    char *comp_buf_;
+
+    //压缩并写出缓冲中的数据，写入bw_即算成功
+    int WriteBlock(const char *src, ssize_t src_len)
+    {
+        char hdr[kBlockHdrLenMax];
+        ssize_t hdr_len = 0;
+        auto append_hdr = [&] (uint64_t n) {
+            auto s = var_int::EncodeUInt(n);
+            memcpy(hdr + hdr_len, s.Data(), s.Len());
+            hdr_len += s.Len();
+        };
+
+        ssize_t comp_len = CompressBlock(src, src_len, comp_buf_);
+        append_hdr(static_cast<uint64_t>(src_len));
+        if (comp_len >= src_len)
+        {
+            append_hdr(0);
+        }
+        else
+        {
+            append_hdr(static_cast<uint64_t>(comp_len));
+            src = comp_buf_;
+            src_len = comp_len;
+        }
+
+        int ret = bw_->WriteAll(hdr, hdr_len);
+        if (ret == 0)
+        {
+            ret = bw_->WriteAll(src, src_len);
+        }
+        return ret;
+    }
+
+public:
+
+    CompressWriter(io::BufWriter::Ptr bw, ssize_t block_sz) :
+        bw_(bw),
+        block_sz_(std::min(std::max<ssize_t>(block_sz <= 0 ? kDefaultBlockSize : block_sz, 4 * 1024), kBlockSizeMax)),
+        buf_(new char[block_sz_]), comp_buf_(new char[CompressBound(block_sz_)])
+    {
+    }
+
+    virtual ~CompressWriter()
+    {
+        delete[] buf_;
+        delete[] comp_buf_;
+    }
+
+    virtual int WriteAll(const char *buf, ssize_t sz) override
+    {
+        if (sz < 0)
+        {
+            SetErr("negative size");
+            errno = EINVAL;
+            return -1;
+        }
+
+        while (sz > 0)
+        {
+            if (len_ == 0 && sz >= block_sz_)
+            {
+                //整块的数据直接压缩，不经过缓冲
+                int ret = WriteBlock(buf, block_sz_);
+                if (ret != 0)
+                {
+                    return ret;
+                }
+                buf += block_sz_;
+                sz -= block_sz_;
+                continue;
+            }
+
+            ssize_t copy_len = std::min(sz, block_sz_ - len_);
+            memcpy(buf_ + len_, buf, copy_len);
+            len_ += copy_len;
+            buf += copy_len;
+            sz -= copy_len;
+            if (len_ == block_sz_)
+            {
+                len_ = 0;
+                int ret = WriteBlock(buf_, block_sz_);
+                if (ret != 0)
+                {
+                    return ret;
+                }
+            }
+        }
+        return 0;
+    }
+
+    virtual int Flush() override
+    {
+        if (len_ > 0)
+        {
+            ssize_t len = len_;
+            len_ = 0;
+            int ret = WriteBlock(buf_, len);
+            if (ret != 0)
+            {
+                return ret;
+            }
+        }
+        return bw_->Flush();
+    }
+};
+
+io::BufWriter::Ptr NewCompressWriter(io::BufWriter::Ptr bw, ssize_t block_sz)
+{
+    return io::BufWriter::Ptr(new CompressWriter(bw, block_sz));
+}
+
+//解压过滤器的下层读函数的状态，每次从br_中取一个完整的块解压，块数据直接以视图的方式从br_的缓冲中读取
+class DecompressSrc
+{
+    io::BufReader::Ptr br_;
+    std::vector<char> block_;
+    ssize_t start_ = 0;
+    ssize_t len_ = 0;
+
+    static ssize_t ErrBadData(const char *msg)
+    {
+        SetErr(msg);
+        errno = EBADMSG;
+        return -1;
+    }
+
+    /*
+    读取下一块并解压，buf空间足够时直接解压到buf
+    返回值：>0为解压到buf的长度，0表示解压到了block_中或EOF（通过len_区分），<0出错
+    */
+    ssize_t NextBlock(char *buf, ssize_t sz)
+    {
+        /*
+        块头是两个var_int，根据各自第一个字节确定长度，只Peek实际需要的长度：
+        Flush出的短块可能比块头的最大长度还短，多要数据会在连接上一直等到对端发送下一块
+        */
+        StrSlice s;
+        auto ret = br_->Peek(1, s);
+        if (ret <= 0)
+        {
+            return ret;
+        }
+        ssize_t hdr_len = var_int::EncodedLen(s.Data()[0]);
+        if (hdr_len < 0)
+        {
+            return ErrBadData("invalid block header");
+        }
+        ret = br_->Peek(hdr_len + 1, s);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        if (ret < hdr_len + 1)
+        {
+            return ErrBadData("truncated block");
+        }
+        ssize_t comp_len_len = var_int::EncodedLen(s.Data()[hdr_len]);
+        if (comp_len_len < 0)
+        {
+            return ErrBadData("invalid block header");
+        }
+        hdr_len += comp_len_len;
+        ret = br_->Peek(hdr_len, s);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        if (ret < hdr_len)
+        {
+            return ErrBadData("truncated block");
+        }
+
+        const char *p = s.Data();
+        ssize_t hdr_sz = hdr_len, raw_len, comp_len;
+        if (!ParseBlockHdr(p, hdr_sz, raw_len, comp_len) || hdr_sz != 0)
+        {
+            return ErrBadData("invalid block header");
+        }
+        ssize_t data_len = BlockDataLen(raw_len, comp_len);
+
+        ret = br_->Peek(hdr_len + data_len, s);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        if (ret < hdr_len + data_len)
+        {
+            return ErrBadData("truncated block");
+        }
+
+        char *dst = buf;
+        if (raw_len > sz)
+        {
+            block_.resize(static_cast<size_t>(raw_len));
+            dst = block_.data();
+        }
+        if (!DecodeBlockData(s.Data() + hdr_len, raw_len, comp_len, dst))
+        {
+            return ErrBadData("corrupted block data");
+        }
+        ret = br_->Discard(hdr_len + data_len);
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        if (dst == buf)
+        {
+            return raw_len;
+        }
+        start_ = 0;
+        len_ = raw_len;
+        return 0;
+    }
+
+public:
+
+    explicit DecompressSrc(io::BufReader::Ptr br) : br_(br)
+    {
+    }
+
+    ssize_t Read(char *buf, ssize_t sz)
+    {
+        if (len_ == 0)
+        {
+            auto ret = NextBlock(buf, sz);
+            if (ret != 0 || len_ == 0)
+            {
+                return ret;
+            }
+        }
+        ssize_t copy_len = std::min(len_, sz);
+        memcpy(buf, block_.data() + start_, copy_len);
+        start_ += copy_len;
+        len_ -= copy_len;
+        return copy_len;
+    }
+};
+
+io::BufReader::Ptr NewDecompressReader(io::BufReader::Ptr br, ssize_t buf_sz)
+{
+    auto src = std::make_shared<DecompressSrc>(br);
+    return io::BufReader::New(
+        [src] (char *buf, ssize_t sz) -> ssize_t {
+            return src->Read(buf, sz);
+        },
+        buf_sz
+    );
+}
+
+}
+
+}
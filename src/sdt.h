@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+静态跟踪点（USDT），生成和systemtap的sys/sdt.h相同格式的.note.stapsdt段，可被bpftrace、perf、systemtap等工具识别，
+例如：bpftrace -e 'usdt:./a.out:lom:conn_read { @[arg2] = count(); }'
+不依赖sys/sdt.h，每个跟踪点在代码中只是一条nop指令，没有运行时开销，参数只在跟踪工具附加后才被读取
+provider统一为lom，参数统一转为int64_t，编译时定义LOM_DISABLE_SDT可以去掉所有跟踪点
+*/
+
+#if !defined(LOM_DISABLE_SDT) && (defined(__x86_64__) || defined(__aarch64__))
+
+#define LOM_SDT_NOTE_ASM(_name, _arg_fmt)                                               \
+    "990: nop\n"                                                                        \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                       \
+    ".balign 4\n"                                                                       \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                                  \
+    "991: .asciz \"stapsdt\"\n"                                                         \
+    "992: .balign 4\n"                                                                  \
+    "993: .8byte 990b\n"                                                                \
+    ".8byte _.stapsdt.base\n"                                                           \
+    ".8byte 0\n"                                                                        \
+    ".asciz \"lom\"\n"                                                                  \
+    ".asciz \"" #_name "\"\n"                                                           \
+    ".asciz \"" _arg_fmt "\"\n"                                                         \
+    "994: .balign 4\n"                                                                  \
+    ".popsection\n"                                                                     \
+    ".ifndef _.stapsdt.base\n"                                                          \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"             \
+    ".weak _.stapsdt.base\n"                                                            \
+    ".hidden _.stapsdt.base\n"                                                          \
+    "_.stapsdt.base: .space 1\n"                                                        \
+    ".size _.stapsdt.base, 1\n"                                                         \
+    ".popsection\n"                                                                     \
+    ".endif\n"
+
+#define LOM_SDT_ARG(_a) "nor"(static_cast<int64_t>(_a))
+
+#define LOM_SDT_PROBE(_name) do {                                                       \
+    __asm__ __volatile__ (LOM_SDT_NOTE_ASM(_name, ""));                                 \
+} while (false)
+
+#define LOM_SDT_PROBE1(_name, _a1) do {                                                 \
+    __asm__ __volatile__ (LOM_SDT_NOTE_ASM(_name, "-8@%0") :: LOM_SDT_ARG(_a1));        \
+} while (false)
+
+#define LOM_SDT_PROBE2(_name, _a1, _a2) do {                                            \
+    __asm__ __volatile__ (                                                              \
+        LOM_SDT_NOTE_ASM(_name, "-8@%0 -8@%1") :: LOM_SDT_ARG(_a1), LOM_SDT_ARG(_a2));  \
+} while (false)
+
+#define LOM_SDT_PROBE3(_name, _a1, _a2, _a3) do {                                       \
+    __asm__ __volatile__ (                                                              \
+        LOM_SDT_NOTE_ASM(_name, "-8@%0 -8@%1 -8@%2") ::                                 \
+            LOM_SDT_ARG(_a1), LOM_SDT_ARG(_a2), LOM_SDT_ARG(_a3));                      \
+} while (false)
+
+#else
+
+#define LOM_SDT_PROBE(_name) do {} while (false)
+#define LOM_SDT_PROBE1(_name, _a1) do {} while (false)
+#define LOM_SDT_PROBE2(_name, _a1, _a2) do {} while (false)
+#define LOM_SDT_PROBE3(_name, _a1, _a2, _a3) do {} while (false)
+
+#endif
@@ -299,47 +299,52 @@ bool DecodeUInt(const char *&p, ssize_t &sz, uint64_t &n)
     return false;
 }
 
-static bool LoadEncodedFrom(const io::BufReader::Ptr &br, std::string &s)
+ssize_t EncodedLen(char first_byte)
 {
-    s.resize(1);
-    ssize_t ret = br->ReadFull(&s[0], 1);
-    if (ret != 1)
+    auto b = static_cast<uint8_t>(first_byte);
+    if (b == 0x0F || b == 0xF8)
     {
-        ret < 0 ?
-            PushErrBT() :
-            SetErr("ReadFull first byte failed: EOF");
-        return false;
+        return 9;
     }
-
-    ssize_t remain_len = 0;
-    auto b = static_cast<uint8_t>(s[0]);
-    if (b == 0x0F || b == 0xF8)
+    if ((b & 0xF0) == 0x10 || (b & 0xF8) == 0xF0)
     {
-        remain_len = 8;
+        return 6;
     }
-    else if ((b & 0xF0) == 0x10 || (b & 0xF8) == 0xF0)
+    if ((b & 0xF0) == 0xE0)
     {
-        remain_len = 5;
+        return 4;
     }
-    else if ((b & 0xF0) == 0xE0)
+    if ((b & 0xE0) == 0x20)
     {
-        remain_len = 3;
+        return 3;
     }
-    else if ((b & 0xE0) == 0x20)
+    if ((b & 0xE0) == 0xC0)
     {
-        remain_len = 2;
+        return 2;
     }
-    else if ((b & 0xE0) == 0xC0)
+    if ((b & 0xC0) == 0x40 || (b & 0xC0) == 0x80)
     {
-        remain_len = 1;
+        return 1;
     }
-    else if ((b & 0xC0) == 0x40 || (b & 0xC0) == 0x80)
+    return -1;
+}
+
+static bool LoadEncodedFrom(const io::BufReader::Ptr &br, std::string &s)
+{
+    s.resize(1);
+    ssize_t ret = br->ReadFull(&s[0], 1);
+    if (ret != 1)
     {
-        remain_len = 0;
+        ret < 0 ?
+            PushErrBT() :
+            SetErr("ReadFull first byte failed: EOF");
+        return false;
     }
-    else
+
+    ssize_t remain_len = EncodedLen(s[0]) - 1;
+    if (remain_len < 0)
     {
-        SetErr(Sprintf("invalid first byte [0x%02X]", b));
+        SetErr(Sprintf("invalid first byte [0x%02X]", static_cast<uint8_t>(s[0])));
         return false;
     }
 
@@ -0,0 +1,140 @@
+#include "../../include/lom.h"
+#include "../../include/lom/fiber/co.h"
+
+/*
+C++20无栈协程接口的测试，以C++20编译（见extra_flags），同时保证co.h能通过编译：
+    协程实现的echo服务，由普通fiber作为客户端访问，检查收发的数据
+    co::Acquire的正常获取、零值获取和超时，co::SleepMS和嵌套Task的返回值
+全部检查通过后输出ok，否则断言失败退出
+*/
+
+using namespace lom;
+using namespace lom::fiber;
+
+static const int kClientCount = 10, kRoundCount = 100;
+static const uint16_t kPort = 23456;
+
+static int finished_client_count = 0;
+static bool sem_checked = false;
+
+static co::Task<> Echo(Conn conn)
+{
+    char buf[1024];
+    for (;;)
+    {
+        ssize_t ret = co_await co::Read(conn, buf, sizeof(buf));
+        if (ret <= 0 || co_await co::WriteAll(conn, buf, ret) != 0)
+        {
+            break;
+        }
+    }
+    conn.Close();
+}
+
+static co::Task<int> Add(int a, int b)
+{
+    co_await co::Yield();
+    co_return a + b;
+}
+
+static co::Task<> CheckSem(Sem sem)
+{
+    Assert(co_await co::Acquire(sem, 0) == 0);
+
+    int64_t start_at = NowMS();
+    Assert(co_await co::Acquire(sem, 2, 1000) == 0);
+    Assert(NowMS() - start_at < 1000);
+
+    start_at = NowMS();
+    Assert(co_await co::Acquire(sem, 1, 50) == err_code::kTimeout);
+    Assert(NowMS() - start_at >= 50);
+
+    start_at = NowMS();
+    co_await co::SleepMS(30);
+    Assert(NowMS() - start_at >= 30);
+
+    int sum = 0;
+    for (int i = 0; i < 1000; ++ i)
+    {
+        sum += co_await Add(i, 1);
+    }
+    Assert(sum == 1000 * 1001 / 2);
+
+    sem.Destroy();
+    sem_checked = true;
+}
+
+static void RunClient(int idx)
+{
+    Conn conn = ConnectTCP("127.0.0.1", kPort);
+    Assert(conn.Valid());
+    for (int i = 0; i < kRoundCount; ++ i)
+    {
+        Str req = Sprintf("client %d round %d", idx, i);
+        Assert(conn.WriteAll(req.Data(), req.Len()) == 0);
+        char buf[1024];
+        ssize_t got = 0;
+        while (got < req.Len())
+        {
+            ssize_t ret = conn.Read(buf + got, sizeof(buf) - got);
+            Assert(ret > 0);
+            got += ret;
+        }
+        Assert(StrSlice(buf, got) == req.Slice());
+    }
+    conn.Close();
+
+    ++ finished_client_count;
+    if (finished_client_count == kClientCount)
+    {
+        while (!sem_checked)
+        {
+            SleepMS(10);
+        }
+        printf("ok\n");
+        exit(0);
+    }
+}
+
+int main()
+{
+    MustInit();
+
+    Sem sem = Sem::New(0);
+    co::Spawn(CheckSem(sem));
+    Create(
+        [sem] () {
+            SleepMS(20);
+            sem.Release(1);
+            SleepMS(20);
+            sem.Release(1);
+        }
+    );
+
+    Listener listener = ListenTCP(kPort);
+    Assert(listener.Valid());
+    Create(
+        [listener] () {
+            for (;;)
+            {
+                Conn conn = listener.Accept();
+                if (!conn.Valid())
+                {
+                    return;
+                }
+                co::Spawn(Echo(conn));
+            }
+        }
+    );
+
+    for (int i = 0; i < kClientCount; ++ i)
+    {
+        Create(
+            [i] () {
+                RunClient(i);
+            }
+        );
+    }
+
+    Run();
+}
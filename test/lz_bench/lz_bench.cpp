@@ -0,0 +1,123 @@
+#include "../../include/lom.h"
+
+/*
+lz压缩的性能测试，对几种典型数据分别测试压缩率和压缩、解压的吞吐
+    log：类似访问日志的文本行
+    kv：类似复制流的变长key-value记录（var_int长度前缀，value是结构化的数据）
+    rand：随机数据，基本不可压缩，用于观察快速跳过的效果
+*/
+
+static ssize_t data_sz = 64 * 1024 * 1024;
+
+static lom::Str GenLog()
+{
+    static const char *methods[] = {"GET", "POST", "PUT", "DELETE"};
+    static const char *paths[] = {"/api/v1/user", "/api/v1/order", "/static/app.js", "/health", "/api/v2/search"};
+    static const char *agents[] = {"curl/7.68.0", "Mozilla/5.0 (X11; Linux x86_64)", "Go-http-client/1.1"};
+
+    lom::Str::Buf buf;
+    int64_t ts = 1700000000000;
+    while (buf.Len() < data_sz)
+    {
+        ts += lom::RandN(1000);
+        buf.Append(lom::Sprintf(
+            "%lld 10.%d.%d.%d %s %s?id=%llu %d %llu \"%s\"\n",
+            static_cast<long long>(ts), static_cast<int>(lom::RandN(4)), static_cast<int>(lom::RandN(256)),
+            static_cast<int>(lom::RandN(256)), methods[lom::RandN(4)], paths[lom::RandN(5)],
+            static_cast<unsigned long long>(lom::RandN(1000000)), lom::RandN(10) == 0 ? 500 : 200,
+            static_cast<unsigned long long>(lom::RandN(100000)), agents[lom::RandN(3)]).Slice());
+    }
+    return lom::Str(std::move(buf));
+}
+
+static lom::Str GenKV()
+{
+    lom::Str::Buf buf;
+    uint64_t seq = 0;
+    while (buf.Len() < data_sz)
+    {
+        auto k = lom::Sprintf("user:%08llu", static_cast<unsigned long long>(lom::RandN(10000000)));
+        auto v = lom::Sprintf(
+            "{\"seq\":%llu,\"balance\":%llu,\"level\":%d,\"tags\":[\"vip\",\"active\"],\"region\":\"cn-%d\"}",
+            static_cast<unsigned long long>(++ seq), static_cast<unsigned long long>(lom::RandN(100000000)),
+            static_cast<int>(lom::RandN(10)), static_cast<int>(lom::RandN(8)));
+        buf.Append(lom::var_int::EncodeUInt(static_cast<uint64_t>(k.Len())).Slice());
+        buf.Append(k.Slice());
+        buf.Append(lom::var_int::EncodeUInt(static_cast<uint64_t>(v.Len())).Slice());
+        buf.Append(v.Slice());
+    }
+    return lom::Str(std::move(buf));
+}
+
+static lom::Str GenRand()
+{
+    lom::Str::Buf buf(data_sz);
+    for (ssize_t i = 0; i < data_sz; i += 8)
+    {
+        uint64_t n = lom::RandN(~static_cast<uint64_t>(0));
+        memcpy(buf.Data() + i, &n, std::min<ssize_t>(8, data_sz - i));
+    }
+    return lom::Str(std::move(buf));
+}
+
+static void Bench(const char *name, const lom::Str &data)
+{
+    auto mb = static_cast<double>(data.Len()) / (1024 * 1024);
+
+    auto ts = lom::NowFloat();
+    auto c = lom::lz::Compress(data.Slice());
+    auto comp_tm = lom::NowFloat() - ts;
+
+    lom::Str out;
+    ts = lom::NowFloat();
+    bool ok = lom::lz::Decompress(c.Slice(), out);
+    auto decomp_tm = lom::NowFloat() - ts;
+    if (!ok || out != data)
+    {
+        fprintf(stderr, "%s: decompress failed\n", name);
+        exit(1);
+    }
+
+    //流式接口，压缩过滤器在内存中的BufWriter之上，模拟小块写入
+    lom::Str::Buf wire;
+    auto bw = lom::io::BufWriter::New(
+        [&wire] (const char *buf, ssize_t sz) -> ssize_t {
+            wire.Append(buf, sz);
+            return sz;
+        }
+    );
+    auto cw = lom::lz::NewCompressWriter(bw);
+    ts = lom::NowFloat();
+    for (ssize_t i = 0; i < data.Len(); i += 200)
+    {
+        if (cw->WriteAll(data.Data() + i, std::min<ssize_t>(200, data.Len() - i)) != 0 || (i + 200 >= data.Len() && cw->Flush() != 0))
+        {
+            fprintf(stderr, "%s: compress writer failed\n", name);
+            exit(1);
+        }
+    }
+    auto stream_tm = lom::NowFloat() - ts;
+
+    printf(
+        "%-5s %8.1f MB  ratio %6.3f  compress %8.1f MB/s  decompress %8.1f MB/s  stream compress %8.1f MB/s\n",
+        name, mb, static_cast<double>(c.Len()) / static_cast<double>(data.Len()),
+        mb / comp_tm, mb / decomp_tm, mb / stream_tm);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+    {
+        int64_t mb;
+        if (!lom::Str(argv[1]).ParseInt64(mb) || mb <= 0 || mb > 1024)
+        {
+            fprintf(stderr, "invalid data size (MB) arg\n");
+            exit(1);
+        }
+        data_sz = mb * 1024 * 1024;
+    }
+
+    Bench("log", GenLog());
+    Bench("kv", GenKV());
+    Bench("rand", GenRand());
+}